@@ -6,121 +6,76 @@
 #include <map>
 #include <algorithm>
 #include <limits>
+#include "../Shared/orderedIndex.h"
 
 using namespace std;
 
-// Node for BST
+// Event details, stored in the event index by name
 class EventNode {
 public:
     string name;
     string category;
-    EventNode* left;
-    EventNode* right;
     list<pair<string, string>> participants; // Pair of participant name and ID
-    EventNode(string n, string c) : name(n), category(c), left(nullptr), right(nullptr) {}
+    EventNode(string n, string c) : name(n), category(c) {}
 };
 
-// BST for Event Searching and Organization
+// Ordered index of events by name (a B+ tree, see Shared/orderedIndex.h)
 class EventBST {
 public:
-    EventNode* root;
-
-    EventBST() : root(nullptr) {}
+    ~EventBST() {
+        events.forEach([](const string&, EventNode* event) { delete event; });
+    }
 
-    void insert(string name, string category) {
-        root = insertHelper(root, name, category);
+    // Add an event, or return the existing one with that name
+    EventNode* insert(string name, string category) {
+        if (EventNode** existing = events.find(name)) return *existing;
+        EventNode* event = new EventNode(name, category);
+        events.insert(name, event);
+        return event;
     }
 
     EventNode* search(string name) {
-        return searchHelper(root, name);
+        EventNode** event = events.find(name);
+        return event ? *event : nullptr;
     }
 
     void displayByCategory(const string& category) {
         string lowerCategory = category;
         transform(lowerCategory.begin(), lowerCategory.end(), lowerCategory.begin(), ::tolower);
-        displayByCategoryHelper(root, lowerCategory);
-    }
-
-    void inorderTraversal() {
-        inorderHelper(root);
-    }
-
-    void deleteEvent(const string& name) {
-        root = deleteHelper(root, name);
-    }
-
-private:
-    EventNode* insertHelper(EventNode* node, string name, string category) {
-        if (!node) return new EventNode(name, category);
-        if (name < node->name) node->left = insertHelper(node->left, name, category);
-        else if (name > node->name) node->right = insertHelper(node->right, name, category);
-        return node;
-    }
-
-    EventNode* searchHelper(EventNode* node, string name) {
-        if (!node || node->name == name) return node;
-        if (name < node->name) return searchHelper(node->left, name);
-        return searchHelper(node->right, name);
-    }
-
-    void displayByCategoryHelper(EventNode* node, const string& category) {
-        if (node) {
-            displayByCategoryHelper(node->left, category);
-            
+        events.forEach([&](const string&, EventNode* node) {
             // Convert the event's category to lower case for comparison
             string eventCategory = node->category;
             transform(eventCategory.begin(), eventCategory.end(), eventCategory.begin(), ::tolower);
-            
-            if (eventCategory == category) {
+
+            if (eventCategory == lowerCategory) {
                 cout << "Event: " << node->name << "\n";
                 for (const auto& participant : node->participants) {
                     cout << "- " << participant.first << " (ID: " << participant.second << ")\n";
                 }
             }
-            
-            displayByCategoryHelper(node->right, category);
-        }
+        });
     }
 
-    void inorderHelper(EventNode* node) {
-        if (node) {
-            inorderHelper(node->left);
+    void inorderTraversal() {
+        events.forEach([](const string&, EventNode* node) {
             cout << "Event: " << node->name 
                  << " (Category: " << node->category << ")\n";
             for (const auto& participant : node->participants) {
                 cout << "- " << participant.first << " (ID: " << participant.second << ")\n";
             }
-            inorderHelper(node->right);
-        }
+        });
     }
-    
-    EventNode* deleteHelper(EventNode* node, const string& name) {
-        if (!node) return node;
-        if (name < node->name) node->left = deleteHelper(node->left, name);
-        else if (name > node->name) node->right = deleteHelper(node->right, name);
-        else {
-            if (!node->left) {
-                EventNode* temp = node->right;
-                delete node;
-                return temp;
-            } else if (!node->right) {
-                EventNode* temp = node->left;
-                delete node;
-                return temp;
-            }
 
-            EventNode* temp = findMin(node->right);
-            node->name = temp->name;
-            node->category = temp->category;
-            node->right = deleteHelper(node->right, temp->name);
+    void deleteEvent(const string& name) {
+        EventNode* event = search(name);
+        if (event) {
+            events.erase(name);
+            delete event;
         }
-        return node;
     }
 
-    EventNode* findMin(EventNode* node) {
-        while (node && node->left) node = node->left;
-        return node;
-    }
+private:
+    OrderedIndex<string, EventNode*> events;
 };
 
 // Event Management System Class
@@ -137,8 +92,7 @@ private:
 public:
     // Create Event
     void createEvent(const string& name, const string& category, int priority) {
-        EventNode* event = new EventNode(name, category);
-        eventBST.insert(name, category);
+        EventNode* event = eventBST.insert(name, category);
         scheduledEvents.push({priority, event});
     }
 
@@ -179,13 +133,10 @@ public:
 
             // Proceed with the update
             eventBST.deleteEvent(oldName);
-            eventBST.insert(newName, category);
 
             // Add the updated event back to the scheduled events queue
-            EventNode* updatedEvent = eventBST.search(newName);
-            if (updatedEvent) {
-                scheduledEvents.push({priority, updatedEvent});
-            }
+            EventNode* updatedEvent = eventBST.insert(newName, category);
+            scheduledEvents.push({priority, updatedEvent});
 
             cout << "Event updated successfully.\n";
 
@@ -0,0 +1,511 @@
+#ifndef DELIVERED_HISTORY_H
+#define DELIVERED_HISTORY_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "writeAheadLog.h"
+
+// Interns repeated strings (recipients, addresses) as 32-bit codes. Each
+// string is stored once; the lookup map keys are views into values, which a
+// deque never moves.
+class StringDictionary {
+public:
+    uint32_t intern(const std::string& value) {
+        auto it = codes.find(value);
+        if (it != codes.end()) return it->second;
+        uint32_t code = static_cast<uint32_t>(values.size());
+        values.push_back(value);
+        codes.emplace(values.back(), code);
+        return code;
+    }
+
+    const std::string& at(uint32_t code) const { return values[code]; }
+
+    size_t size() const { return values.size(); }
+
+    void clear() {
+        codes.clear();
+        values.clear();
+    }
+
+private:
+    std::deque<std::string> values;
+    std::unordered_map<std::string_view, uint32_t> codes;
+};
+
+// One delivered parcel as handed out by DeliveredHistory
+struct DeliveryRecord {
+    int id;
+    int priority;
+    int64_t deliveredAt; // seconds since epoch
+    const std::string& recipient;
+    const std::string& address;
+    double x; // Where it was dropped, km east and north of the depot
+    double y;
+};
+
+// Append-only, column-per-field store of delivered parcels. Rows are kept in
+// delivery-time order, so a time range maps to a contiguous slice. Totals and
+// per-priority / per-hour histograms are updated on append, never recomputed.
+// When a spill file is set, full batches of rows are delta/varint encoded and
+// written out as segments; only the tail batch and its dictionary stay in
+// memory. A segment is a run of blocks of blockRows rows, each with the strings
+// its rows use, followed by an index of each block's first delivery time, so a
+// time-range query reads only the blocks it needs. saveState() records the
+// segment list rather than the rows, so snapshots stay small however long the
+// history.
+class DeliveredHistory {
+public:
+    void append(int id, int priority, const std::string& recipient, const std::string& address, int64_t when,
+                double x, double y) {
+        // Keep timestamps sorted even if the wall clock steps backwards
+        if (when < lastTime) when = lastTime;
+        lastTime = when;
+
+        ids.push_back(id);
+        priorities.push_back(priority);
+        times.push_back(when);
+        recipients.push_back(strings.intern(recipient));
+        addresses.push_back(strings.intern(address));
+        xs.push_back(x);
+        ys.push_back(y);
+
+        total++;
+        perPriority[priority]++;
+        perHour[hourOf(when)]++;
+
+        if (!spillPath.empty() && ids.size() >= spillRows) spill();
+    }
+
+    // Spill batches of rowsPerSegment rows to path. The file can only be set once:
+    // switching files would lose the rows already spilled. Nothing already in the
+    // file is overwritten: new segments go after it until resumeSpillFile() says
+    // which bytes the history owns. Returns false if a file is already set or the
+    // file can't be opened.
+    bool setSpillFile(const std::string& path, size_t rowsPerSegment) {
+        if (!spillPath.empty()) return false;
+        std::FILE* file = std::fopen(path.c_str(), "ab");
+        if (!file) return false;
+        std::fclose(file);
+        spillPath = path;
+        spillRows = std::max<size_t>(1, rowsPerSegment);
+        if (ids.size() >= spillRows) spill();
+        return true;
+    }
+
+    // Cut the spill file back to the segments this history lists: everything for
+    // a new history, or what restoreState() brought back, dropping segments spilled
+    // after that state was saved (their rows come back through the log). Call
+    // once recovery has succeeded, before anything else is spilled.
+    bool resumeSpillFile() {
+        if (spillPath.empty()) return true;
+        std::error_code error;
+        std::filesystem::resize_file(spillPath, spillBytes, error);
+        return !error;
+    }
+
+    // Spill the in-memory rows, however few, and sync the spill file, so every
+    // segment saveState() lists is on disk. True if there is no spill file.
+    bool flush() {
+        if (spillPath.empty()) return true;
+        if (!ids.empty() && !spill()) return false;
+        std::FILE* file = std::fopen(spillPath.c_str(), "ab");
+        if (!file) return false;
+        bool ok = syncFile(file);
+        std::fclose(file);
+        return ok;
+    }
+
+    // Aggregates, the segment list and the rows still in memory
+    void saveState(ByteWriter& out) const {
+        out.i64(lastTime);
+        out.u64(total);
+        out.u32(static_cast<uint32_t>(perPriority.size()));
+        for (const auto& [priority, count] : perPriority) {
+            out.i32(priority);
+            out.u64(count);
+        }
+        for (size_t count : perHour) out.u64(count);
+        out.u64(spillBytes);
+        out.u32(static_cast<uint32_t>(segments.size()));
+        for (const Segment& segment : segments) {
+            out.u64(segment.offset);
+            out.u64(segment.bytes);
+            out.u64(segment.rows);
+            out.i64(segment.firstTime);
+            out.i64(segment.lastTime);
+            out.u64(segment.indexBytes);
+        }
+        out.u64(ids.size());
+        out.str(encodeRows(0, ids.size()));
+    }
+
+    // Load what saveState() wrote into an empty history. The spill file must
+    // already be set if there are segments, and hold at least the bytes they
+    // cover. On failure the history is left empty; the spill file is never
+    // changed here (see resumeSpillFile()).
+    bool restoreState(ByteReader& in) {
+        if (!readState(in)) {
+            clear();
+            return false;
+        }
+        return true;
+    }
+
+    // Forget every row and aggregate; the spill file setting is kept
+    void clear() {
+        ids.clear();
+        priorities.clear();
+        times.clear();
+        recipients.clear();
+        addresses.clear();
+        xs.clear();
+        ys.clear();
+        strings.clear();
+        lastTime = INT64_MIN;
+        total = 0;
+        perPriority.clear();
+        perHour.fill(0);
+        segments.clear();
+        spillBytes = 0;
+    }
+
+    size_t size() const { return total; }
+    size_t inMemoryRows() const { return ids.size(); }
+    size_t spilledSegments() const { return segments.size(); }
+    const std::map<int, size_t>& countsByPriority() const { return perPriority; }
+    const std::array<size_t, 24>& countsByHour() const { return perHour; }
+
+    // Visit every delivery in [from, to], oldest first. Segments are binary-searched
+    // by time, and within each only the blocks that overlap the range are read, so
+    // a short range costs its own rows plus at most a block either side.
+    template <typename Visitor>
+    void forEachInRange(int64_t from, int64_t to, Visitor visit) const {
+        auto segment = std::lower_bound(segments.begin(), segments.end(), from,
+                                        [](const Segment& s, int64_t time) { return s.lastTime < time; });
+        for (; segment != segments.end() && segment->firstTime <= to; ++segment) {
+            visitSegment(*segment, from, to, visit);
+        }
+        visitRange(ids, priorities, times, recipients, addresses, xs, ys, strings, from, to, visit);
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        forEachInRange(INT64_MIN, INT64_MAX, visit);
+    }
+
+    static int hourOf(int64_t when) {
+        std::time_t t = static_cast<std::time_t>(when);
+        std::tm* local = std::localtime(&t);
+        return local ? local->tm_hour : 0;
+    }
+
+private:
+    struct Segment {
+        uint64_t offset;
+        uint64_t bytes;
+        uint64_t rows;
+        int64_t firstTime;
+        int64_t lastTime;
+        uint64_t indexBytes; // the block index at the end of the segment
+    };
+
+    // One entry of a segment's block index
+    struct Block {
+        uint64_t offset; // from the start of the segment
+        uint64_t bytes;
+        size_t rows;
+        int64_t firstTime;
+    };
+
+    static constexpr size_t blockRows = 1024;
+
+    struct Columns {
+        std::vector<int> ids;
+        std::vector<int> priorities;
+        std::vector<int64_t> times;
+        std::vector<uint32_t> recipients;
+        std::vector<uint32_t> addresses;
+        std::vector<double> xs;
+        std::vector<double> ys;
+        std::vector<std::string> strings; // the segment's own dictionary
+    };
+
+    // In-memory tail
+    std::vector<int> ids;
+    std::vector<int> priorities;
+    std::vector<int64_t> times;
+    std::vector<uint32_t> recipients;
+    std::vector<uint32_t> addresses;
+    std::vector<double> xs;
+    std::vector<double> ys;
+    StringDictionary strings; // only the tail's strings
+    int64_t lastTime = INT64_MIN;
+
+    // Incremental aggregates over the whole history
+    size_t total = 0;
+    std::map<int, size_t> perPriority;
+    std::array<size_t, 24> perHour{};
+
+    // Spilled segments
+    std::string spillPath;
+    size_t spillRows = 0;
+    std::vector<Segment> segments;
+    uint64_t spillBytes = 0;
+
+    bool readState(ByteReader& in) {
+        lastTime = in.i64();
+        total = in.u64();
+        uint32_t count = in.u32();
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            int priority = in.i32();
+            perPriority[priority] = in.u64();
+        }
+        for (size_t& hourCount : perHour) hourCount = in.u64();
+        spillBytes = in.u64();
+        count = in.u32();
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            Segment segment;
+            segment.offset = in.u64();
+            segment.bytes = in.u64();
+            segment.rows = in.u64();
+            segment.firstTime = in.i64();
+            segment.lastTime = in.i64();
+            segment.indexBytes = in.u64();
+            if (segment.indexBytes > segment.bytes || segment.offset + segment.bytes > spillBytes) return false;
+            segments.push_back(segment);
+        }
+        uint64_t rows = in.u64();
+        std::string tail = in.str();
+        if (!in.ok()) return false;
+
+        if (!segments.empty()) {
+            if (spillPath.empty()) return false;
+            std::error_code error;
+            uint64_t size = std::filesystem::file_size(spillPath, error);
+            if (error || size < spillBytes) return false;
+        }
+
+        Columns columns = decode(tail, rows);
+        if (columns.ids.size() != rows) return false;
+        for (size_t i = 0; i < rows; i++) {
+            ids.push_back(columns.ids[i]);
+            priorities.push_back(columns.priorities[i]);
+            times.push_back(columns.times[i]);
+            recipients.push_back(strings.intern(columns.strings.at(columns.recipients[i])));
+            addresses.push_back(strings.intern(columns.strings.at(columns.addresses[i])));
+            xs.push_back(columns.xs[i]);
+            ys.push_back(columns.ys[i]);
+        }
+        return true;
+    }
+
+    template <typename Strings, typename Visitor>
+    void visitRange(const std::vector<int>& idCol, const std::vector<int>& priorityCol,
+                    const std::vector<int64_t>& timeCol, const std::vector<uint32_t>& recipientCol,
+                    const std::vector<uint32_t>& addressCol, const std::vector<double>& xCol,
+                    const std::vector<double>& yCol, const Strings& stringsOf, int64_t from, int64_t to,
+                    Visitor& visit) const {
+        size_t begin = std::lower_bound(timeCol.begin(), timeCol.end(), from) - timeCol.begin();
+        size_t end = std::upper_bound(timeCol.begin(), timeCol.end(), to) - timeCol.begin();
+        for (size_t i = begin; i < end; i++) {
+            visit(DeliveryRecord{idCol[i], priorityCol[i], timeCol[i], stringsOf.at(recipientCol[i]),
+                                 stringsOf.at(addressCol[i]), xCol[i], yCol[i]});
+        }
+    }
+
+    static void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out += static_cast<char>((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out += static_cast<char>(value);
+    }
+
+    static uint64_t getVarint(const std::string& in, size_t& pos) {
+        uint64_t value = 0;
+        for (int shift = 0; pos < in.size() && shift < 64; shift += 7) {
+            unsigned char byte = static_cast<unsigned char>(in[pos++]);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        return value;
+    }
+
+    static uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    static int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    static uint64_t bitsOf(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return bits;
+    }
+
+    static double fromBits(uint64_t bits) {
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+
+    // Tail rows [begin, end) column by column, followed by the strings they use.
+    // Positions are XORed with the previous row's, so parcels dropped at the same
+    // stop cost a byte each.
+    std::string encodeRows(size_t begin, size_t end) const {
+        std::string out;
+        if (begin == end) return out;
+        StringDictionary used; // Codes local to these rows
+        std::vector<uint32_t> recipientCodes, addressCodes;
+        for (size_t i = begin; i < end; i++) {
+            recipientCodes.push_back(used.intern(strings.at(recipients[i])));
+            addressCodes.push_back(used.intern(strings.at(addresses[i])));
+        }
+        int64_t prev = 0;
+        for (size_t i = begin; i < end; i++) { putVarint(out, zigzag(ids[i] - prev)); prev = ids[i]; }
+        for (size_t i = begin; i < end; i++) putVarint(out, zigzag(priorities[i]));
+        prev = times[begin];
+        putVarint(out, zigzag(prev));
+        for (size_t i = begin + 1; i < end; i++) { putVarint(out, static_cast<uint64_t>(times[i] - prev)); prev = times[i]; }
+        for (uint32_t code : recipientCodes) putVarint(out, code);
+        for (uint32_t code : addressCodes) putVarint(out, code);
+        for (const std::vector<double>* column : {&xs, &ys}) {
+            uint64_t prevBits = 0;
+            for (size_t i = begin; i < end; i++) { putVarint(out, bitsOf((*column)[i]) ^ prevBits); prevBits = bitsOf((*column)[i]); }
+        }
+        putVarint(out, used.size());
+        for (uint32_t code = 0; code < used.size(); code++) {
+            putVarint(out, used.at(code).size());
+            out += used.at(code);
+        }
+        return out;
+    }
+
+    static Columns decode(const std::string& in, size_t rows) {
+        Columns columns;
+        if (rows == 0) return columns;
+        size_t pos = 0;
+        int64_t prev = 0;
+        for (size_t i = 0; i < rows; i++) {
+            prev += unzigzag(getVarint(in, pos));
+            columns.ids.push_back(static_cast<int>(prev));
+        }
+        for (size_t i = 0; i < rows; i++) columns.priorities.push_back(static_cast<int>(unzigzag(getVarint(in, pos))));
+        prev = unzigzag(getVarint(in, pos));
+        columns.times.push_back(prev);
+        for (size_t i = 1; i < rows; i++) {
+            prev += static_cast<int64_t>(getVarint(in, pos));
+            columns.times.push_back(prev);
+        }
+        for (size_t i = 0; i < rows; i++) columns.recipients.push_back(static_cast<uint32_t>(getVarint(in, pos)));
+        for (size_t i = 0; i < rows; i++) columns.addresses.push_back(static_cast<uint32_t>(getVarint(in, pos)));
+        for (std::vector<double>* column : {&columns.xs, &columns.ys}) {
+            uint64_t bits = 0;
+            for (size_t i = 0; i < rows; i++) { bits ^= getVarint(in, pos); column->push_back(fromBits(bits)); }
+        }
+        size_t count = getVarint(in, pos);
+        for (size_t i = 0; i < count && pos < in.size(); i++) {
+            size_t length = std::min<size_t>(getVarint(in, pos), in.size() - pos);
+            columns.strings.push_back(in.substr(pos, length));
+            pos += length;
+        }
+        return columns;
+    }
+
+    // Append the in-memory tail to the end of the spill file as a segment. Returns
+    // false, keeping the rows in memory, if the disk write failed.
+    bool spill() {
+        std::string out, index;
+        int64_t prevTime = 0;
+        for (size_t begin = 0; begin < ids.size(); begin += blockRows) {
+            size_t end = std::min(ids.size(), begin + blockRows);
+            std::string block = encodeRows(begin, end);
+            putVarint(index, block.size());
+            putVarint(index, end - begin);
+            putVarint(index, zigzag(times[begin] - prevTime));
+            prevTime = times[begin];
+            out += block;
+        }
+        out += index;
+        std::error_code error;
+        uint64_t offset = std::filesystem::file_size(spillPath, error);
+        if (error) return false;
+        std::FILE* file = std::fopen(spillPath.c_str(), "ab");
+        if (!file) return false;
+        bool ok = std::fwrite(out.data(), 1, out.size(), file) == out.size();
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok) {
+            std::filesystem::resize_file(spillPath, offset, error); // Drop the torn write
+            return false;
+        }
+
+        segments.push_back({offset, out.size(), ids.size(), times.front(), times.back(), index.size()});
+        spillBytes = offset + out.size();
+        ids.clear();
+        priorities.clear();
+        times.clear();
+        recipients.clear();
+        addresses.clear();
+        xs.clear();
+        ys.clear();
+        strings.clear();
+        return true;
+    }
+
+    bool readBytes(uint64_t offset, uint64_t size, std::string& in) const {
+        in.assign(size, '\0');
+        std::ifstream file(spillPath, std::ios::binary);
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(&in[0], static_cast<std::streamsize>(size));
+        return static_cast<bool>(file);
+    }
+
+    // Read the segment's block index, then the run of blocks that can hold rows
+    // in [from, to]: from the last block starting before `from` to the last one
+    // starting at or before `to`.
+    template <typename Visitor>
+    void visitSegment(const Segment& segment, int64_t from, int64_t to, Visitor& visit) const {
+        std::string in;
+        if (!readBytes(segment.offset + segment.bytes - segment.indexBytes, segment.indexBytes, in)) return;
+        std::vector<Block> blocks;
+        uint64_t offset = 0, rows = 0;
+        int64_t time = 0;
+        for (size_t pos = 0; pos < in.size();) {
+            Block block;
+            block.offset = offset;
+            block.bytes = getVarint(in, pos);
+            block.rows = getVarint(in, pos);
+            time += unzigzag(getVarint(in, pos));
+            block.firstTime = time;
+            offset += block.bytes;
+            rows += block.rows;
+            blocks.push_back(block);
+        }
+        if (blocks.empty() || offset + segment.indexBytes != segment.bytes || rows != segment.rows) return;
+
+        size_t first = std::lower_bound(blocks.begin(), blocks.end(), from,
+                                        [](const Block& b, int64_t t) { return b.firstTime < t; }) - blocks.begin();
+        if (first > 0) first--;
+        size_t last = first;
+        while (last + 1 < blocks.size() && blocks[last + 1].firstTime <= to) last++;
+        uint64_t start = blocks[first].offset;
+        if (!readBytes(segment.offset + start, blocks[last].offset + blocks[last].bytes - start, in)) return;
+        for (size_t b = first; b <= last; b++) {
+            Columns columns = decode(in.substr(blocks[b].offset - start, blocks[b].bytes), blocks[b].rows);
+            visitRange(columns.ids, columns.priorities, columns.times, columns.recipients, columns.addresses,
+                       columns.xs, columns.ys, columns.strings, from, to, visit);
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,423 @@
+#ifndef DEPOT_SIMULATION_H
+#define DEPOT_SIMULATION_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "parcelDeliverySystem.h"
+
+using SimClock = std::chrono::steady_clock;
+
+// Bounded ring buffer for exactly one producer thread and one consumer thread
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : slots(roundUpPow2(capacity)), mask(slots.size() - 1) {}
+
+    bool tryPush(T&& value) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size()) return false;
+        slots[t & mask] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        value = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        size_t h = head.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_acquire) - h;
+    }
+
+    size_t capacity() const { return slots.size(); }
+
+    static size_t roundUpPow2(size_t n) {
+        size_t p = 2;
+        while (p < n) p <<= 1;
+        return p;
+    }
+
+private:
+    std::vector<T> slots;
+    size_t mask;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+// Bounded ring buffer for many producer threads and one consumer thread.
+// Each slot carries a sequence number telling producers and the consumer
+// whose turn it is, so producers only contend on the enqueue counter.
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t capacity) : cells(SpscRing<T>::roundUpPow2(capacity)), mask(cells.size() - 1) {
+        for (size_t i = 0; i < cells.size(); i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & mask];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+        value = std::move(cell.value);
+        cell.sequence.store(pos + cells.size(), std::memory_order_release);
+        dequeuePos.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const {
+        size_t out = dequeuePos.load(std::memory_order_acquire);
+        size_t in = enqueuePos.load(std::memory_order_acquire);
+        return in > out ? in - out : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::vector<Cell> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+};
+
+// Synthetic workload and depot capacity settings
+struct SimulationConfig {
+    static constexpr size_t maxParcels = 1000000; // every parcel stays in the system's indexes, about 1 KB each
+    static constexpr int maxProducers = 64;
+
+    size_t parcels = 100000;
+    int producers = 2;           // threads submitting registrations
+    double arrivalRate = 0;      // parcels per second over all producers, 0 = as fast as possible
+    int minPriority = 1;
+    int maxPriority = 5;
+    size_t queueCapacity = 1024; // slots in each ring between stages
+    int registerMicros = 0;      // handling time per parcel in each stage, slept on top of the system call
+    int loadMicros = 0;
+    int deliverMicros = 0;
+    unsigned seed = 42;
+};
+
+struct StageStats {
+    std::string name;
+    size_t processed = 0;
+    double seconds = 0;     // first item to last item
+    size_t maxDepth = 0;    // deepest the stage's input queue got
+    double avgDepth = 0;
+    size_t fullStalls = 0;  // times the stage found its output queue full
+    bool hasInput = true;   // the generators have no input queue
+    double systemSeconds = 0; // time spent inside ParcelDeliverySystem calls, lock wait excluded
+
+    double throughput() const { return seconds > 0 ? processed / seconds : 0; }
+    double systemMicrosPerParcel() const { return processed ? systemSeconds * 1e6 / processed : 0; }
+};
+
+struct SimulationReport {
+    std::vector<StageStats> stages;
+    double wallSeconds = 0;
+    double latencyP50 = 0; // end-to-end microseconds, submit to delivered
+    double latencyP90 = 0;
+    double latencyP99 = 0;
+    double latencyMax = 0;
+
+    void print(std::ostream& out) const {
+        out << std::fixed << std::setprecision(1);
+        out << "Simulated " << (stages.empty() ? 0 : stages.back().processed) << " parcels in "
+            << wallSeconds * 1000 << " ms\n";
+        for (const auto& stage : stages) {
+            out << "- " << stage.name << ": " << stage.throughput() << " parcels/s, ";
+            if (stage.hasInput) {
+                out << "input queue avg " << stage.avgDepth << " / max " << stage.maxDepth << ", "
+                    << stage.systemMicrosPerParcel() << " us/parcel in the depot code, ";
+            }
+            out << "blocked on full output " << stage.fullStalls << " times\n";
+        }
+        out << "End-to-end latency (us): p50 " << latencyP50 << ", p90 " << latencyP90 << ", p99 " << latencyP99
+            << ", max " << latencyMax << "\n";
+        out.unsetf(std::ios::floatfield);
+        out << std::setprecision(6);
+    }
+};
+
+// Register -> load -> deliver pipeline, one thread per stage, fed by a
+// configurable number of generator threads. Stages are joined by bounded
+// rings; a stage that finds its output full waits, which slows everything
+// upstream (backpressure). Every stage calls the real registerParcel,
+// loadParcels and deliverParcel on one in-memory ParcelDeliverySystem (no
+// log). The class is single-threaded, so a mutex lets one stage in at a
+// time, as one depot computer would. Configured handling times are slept on
+// top, so they model staff time without using a core.
+class DepotSimulation {
+public:
+    explicit DepotSimulation(const SimulationConfig& config) : config(config) {
+        this->config.parcels = std::min(this->config.parcels, SimulationConfig::maxParcels);
+        this->config.producers = std::clamp(this->config.producers, 1, SimulationConfig::maxProducers);
+        if (this->config.maxPriority < this->config.minPriority) this->config.maxPriority = this->config.minPriority;
+    }
+
+    // Throws std::system_error if a thread can't be started (after stopping the
+    // ones that did) and std::bad_alloc if the queues don't fit in memory
+    SimulationReport run() {
+        cancelled = false;
+        std::ostream silent(nullptr); // The system's messages are not wanted here
+        ParcelDeliverySystem system(silent);
+        std::mutex systemLock;
+        Depot depot{system, systemLock};
+        MpscRing<Request> intake(config.queueCapacity);
+        SpscRing<SimClock::time_point> toLoad(config.queueCapacity); // submit times, in registration order
+        SpscRing<SimClock::time_point> toDeliver(config.queueCapacity);
+        std::atomic<size_t> producerStalls{0};
+        StageStats registerStats{"Register"}, loadStats{"Load"}, deliverStats{"Deliver"};
+        std::vector<double> latencies;
+        latencies.reserve(config.parcels);
+
+        SimClock::time_point start = SimClock::now();
+        std::vector<std::thread> threads;
+        try {
+            for (int p = 0; p < config.producers; p++) {
+                threads.emplace_back([&, p] { generate(p, start, intake, producerStalls); });
+            }
+            threads.emplace_back([&] { registerStage(depot, intake, toLoad, registerStats); });
+            threads.emplace_back([&] { loadStage(depot, toLoad, toDeliver, loadStats); });
+            threads.emplace_back([&] { deliverStage(depot, toDeliver, deliverStats, latencies); });
+        } catch (...) {
+            // The started threads would wait forever for the missing ones; stop them before unwinding
+            cancelled = true;
+            for (auto& t : threads) t.join();
+            throw;
+        }
+        for (auto& t : threads) t.join();
+
+        SimulationReport report;
+        report.wallSeconds = std::chrono::duration<double>(SimClock::now() - start).count();
+        StageStats intakeStats{"Intake"};
+        intakeStats.processed = config.parcels;
+        intakeStats.seconds = report.wallSeconds;
+        intakeStats.fullStalls = producerStalls.load();
+        intakeStats.hasInput = false;
+        report.stages = {intakeStats, registerStats, loadStats, deliverStats};
+
+        std::sort(latencies.begin(), latencies.end());
+        if (!latencies.empty()) {
+            auto at = [&](double q) { return latencies[static_cast<size_t>(q * (latencies.size() - 1))]; };
+            report.latencyP50 = at(0.50);
+            report.latencyP90 = at(0.90);
+            report.latencyP99 = at(0.99);
+            report.latencyMax = latencies.back();
+        }
+        return report;
+    }
+
+private:
+    struct Request {
+        std::string recipient;
+        std::string address;
+        int priority = 0;
+        SimClock::time_point submitted;
+    };
+
+    // The shared system and the lock that lets one stage use it at a time
+    struct Depot {
+        ParcelDeliverySystem& system;
+        std::mutex& lock;
+
+        // Run call on the system; its time, lock wait excluded, is added to stats
+        template <typename Call>
+        void use(StageStats& stats, Call call) {
+            std::lock_guard<std::mutex> guard(lock);
+            SimClock::time_point start = SimClock::now();
+            call(system);
+            stats.systemSeconds += std::chrono::duration<double>(SimClock::now() - start).count();
+        }
+    };
+
+    // Running average and maximum of a stage's input queue depth
+    struct DepthSampler {
+        size_t samples = 0;
+        double total = 0;
+        size_t max = 0;
+
+        void add(size_t depth) {
+            samples++;
+            total += depth;
+            max = std::max(max, depth);
+        }
+
+        void storeInto(StageStats& stats) const {
+            stats.maxDepth = max;
+            stats.avgDepth = samples ? total / samples : 0;
+        }
+    };
+
+    SimulationConfig config;
+    std::atomic<bool> cancelled{false}; // Set when the run is abandoned; every wait gives up
+
+    // Handling time is slept, not spun, so desks and stages don't compete for cores
+    static void handle(int micros) {
+        if (micros > 0) std::this_thread::sleep_for(std::chrono::microseconds(micros));
+    }
+
+    // Yield for a while, then sleep between tries, so idle threads leave the cores to busy ones
+    static void backOff(int tries) {
+        if (tries < 64) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+
+    // Keep trying until the ring accepts the item; count how often it was full.
+    // Returns false if the run was cancelled first.
+    template <typename Ring, typename T>
+    bool pushBlocking(Ring& ring, T&& item, size_t& stalls) {
+        if (ring.tryPush(std::move(item))) return true;
+        stalls++;
+        for (int tries = 0; !ring.tryPush(std::move(item)); tries++) {
+            if (cancelled) return false;
+            backOff(tries);
+        }
+        return true;
+    }
+
+    template <typename Ring, typename T>
+    bool popBlocking(Ring& ring, T& item) {
+        for (int tries = 0; !ring.tryPop(item); tries++) {
+            if (cancelled) return false;
+            backOff(tries);
+        }
+        return true;
+    }
+
+    // Sleep until when, waking regularly to check for cancellation
+    bool sleepUntil(SimClock::time_point when) {
+        while (SimClock::now() < when) {
+            if (cancelled) return false;
+            std::this_thread::sleep_until(std::min(when, SimClock::now() + std::chrono::milliseconds(50)));
+        }
+        return !cancelled;
+    }
+
+    size_t shareOf(int producer) const {
+        size_t base = config.parcels / config.producers;
+        return base + (static_cast<size_t>(producer) < config.parcels % config.producers ? 1 : 0);
+    }
+
+    void generate(int producer, SimClock::time_point start, MpscRing<Request>& intake,
+                  std::atomic<size_t>& producerStalls) {
+        std::mt19937 rng(config.seed + producer);
+        std::uniform_int_distribution<int> priority(config.minPriority, config.maxPriority);
+        std::uniform_int_distribution<int> house(1, 999);
+        double interval = config.arrivalRate > 0 ? config.producers / config.arrivalRate : 0;
+        size_t stalls = 0;
+        for (size_t i = 0, count = shareOf(producer); i < count; i++) {
+            if (interval > 0 && !sleepUntil(start + std::chrono::duration_cast<SimClock::duration>(
+                                                         std::chrono::duration<double>(interval * i)))) {
+                break;
+            }
+            Request request;
+            request.recipient = "Customer " + std::to_string(producer) + "-" + std::to_string(i);
+            request.address = std::to_string(house(rng)) + " Main Street";
+            request.priority = priority(rng);
+            request.submitted = SimClock::now();
+            if (!pushBlocking(intake, std::move(request), stalls)) break;
+        }
+        producerStalls += stalls;
+    }
+
+    void registerStage(Depot& depot, MpscRing<Request>& intake, SpscRing<SimClock::time_point>& toLoad,
+                       StageStats& stats) {
+        DepthSampler depth;
+        SimClock::time_point first;
+        for (size_t i = 0; i < config.parcels; i++) {
+            Request request;
+            if (!popBlocking(intake, request)) return;
+            if (i == 0) first = SimClock::now();
+            depth.add(intake.size());
+            handle(config.registerMicros);
+            depot.use(stats, [&](ParcelDeliverySystem& system) {
+                system.registerParcel(request.recipient, request.address, request.priority);
+            });
+            if (!pushBlocking(toLoad, request.submitted, stats.fullStalls)) return;
+        }
+        finish(stats, depth, first);
+    }
+
+    // The system loads and delivers in registration order, so the i-th parcel
+    // through each stage is the i-th registered and its submit time rides along
+    void loadStage(Depot& depot, SpscRing<SimClock::time_point>& toLoad, SpscRing<SimClock::time_point>& toDeliver,
+                   StageStats& stats) {
+        DepthSampler depth;
+        SimClock::time_point first;
+        for (size_t i = 0; i < config.parcels; i++) {
+            SimClock::time_point submitted;
+            if (!popBlocking(toLoad, submitted)) return;
+            if (i == 0) first = SimClock::now();
+            depth.add(toLoad.size());
+            handle(config.loadMicros);
+            depot.use(stats, [](ParcelDeliverySystem& system) { system.loadParcels(); });
+            if (!pushBlocking(toDeliver, submitted, stats.fullStalls)) return;
+        }
+        finish(stats, depth, first);
+    }
+
+    void deliverStage(Depot& depot, SpscRing<SimClock::time_point>& toDeliver, StageStats& stats,
+                      std::vector<double>& latencies) {
+        DepthSampler depth;
+        SimClock::time_point first;
+        for (size_t i = 0; i < config.parcels; i++) {
+            SimClock::time_point submitted;
+            if (!popBlocking(toDeliver, submitted)) return;
+            if (i == 0) first = SimClock::now();
+            depth.add(toDeliver.size());
+            handle(config.deliverMicros);
+            depot.use(stats, [](ParcelDeliverySystem& system) { system.deliverParcel(); });
+            latencies.push_back(std::chrono::duration<double, std::micro>(SimClock::now() - submitted).count());
+        }
+        finish(stats, depth, first);
+    }
+
+    void finish(StageStats& stats, const DepthSampler& depth, SimClock::time_point first) const {
+        stats.processed = config.parcels;
+        stats.seconds = config.parcels ? std::chrono::duration<double>(SimClock::now() - first).count() : 0;
+        depth.storeInto(stats);
+    }
+};
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef PARCEL_H
+#define PARCEL_H
+
+#include <string>
+
+// Parcel structure
+struct Parcel {
+    int id;
+    std::string recipient;
+    std::string address;
+    int priority; // Lower number means higher priority
+};
+
+// Comparator for priority queue
+struct ComparePriority {
+    bool operator()(Parcel const& p1, Parcel const& p2) const {
+        return p1.priority > p2.priority; // Higher priority parcels come first
+    }
+};
+
+#endif
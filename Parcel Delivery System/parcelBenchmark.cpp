@@ -0,0 +1,416 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "parcelDeliverySystem.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ---- Allocation counting ----
+// Every global new/delete goes through these so each operation can report how
+// many allocations it made and how much heap the run needed at its peak.
+
+namespace {
+size_t allocationCount = 0;
+size_t liveBytes = 0;
+size_t peakLiveBytes = 0;
+const size_t allocationHeader = 16; // keeps the returned pointer 16-byte aligned
+
+void* countedAlloc(size_t size) {
+    void* block = malloc(size + allocationHeader);
+    if (!block) throw bad_alloc();
+    *static_cast<size_t*>(block) = size;
+    allocationCount++;
+    liveBytes += size;
+    peakLiveBytes = max(peakLiveBytes, liveBytes);
+    return static_cast<char*>(block) + allocationHeader;
+}
+
+void countedFree(void* ptr) {
+    if (!ptr) return;
+    void* block = static_cast<char*>(ptr) - allocationHeader;
+    liveBytes -= *static_cast<size_t*>(block);
+    free(block);
+}
+}
+
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+void operator delete(void* ptr) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr) noexcept { countedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { countedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { countedFree(ptr); }
+
+// Peak resident memory of the whole process so far, in KB. Each run gets its
+// own process where fork() is available, so this is the run's own peak.
+size_t peakResidentKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
+// ---- Measurement ----
+
+using BenchClock = chrono::steady_clock;
+
+// Timings and allocations for one kind of operation within a run
+struct OperationStats {
+    string name;
+    vector<uint32_t> samplesNs; // per-call latency, every sampleEvery-th call
+    size_t calls = 0;
+    double seconds = 0;
+    size_t allocations = 0;
+
+    double percentile(double q) const {
+        if (samplesNs.empty()) return 0;
+        return samplesNs[static_cast<size_t>(q * (samplesNs.size() - 1))];
+    }
+};
+
+// One workload at one size
+struct RunResult {
+    string workload;
+    size_t parcels = 0;
+    double seconds = 0;
+    size_t peakHeapBytes = 0;
+    size_t peakResidentKb = 0;
+    bool residentIsProcessWide = false; // Earlier runs shared the process, so RSS may be theirs
+    vector<OperationStats> operations;
+};
+
+class Recorder {
+public:
+    explicit Recorder(size_t sampleEvery) : sampleEvery(sampleEvery) {}
+
+    // Time a single call of the named operation
+    template <typename Call>
+    void measure(const string& name, Call call) {
+        OperationStats& stats = find(name);
+        size_t allocationsBefore = allocationCount;
+        BenchClock::time_point start = BenchClock::now();
+        call();
+        BenchClock::duration elapsed = BenchClock::now() - start;
+        stats.allocations += allocationCount - allocationsBefore;
+        stats.seconds += chrono::duration<double>(elapsed).count();
+        if (stats.calls++ % sampleEvery == 0) {
+            long long ns = chrono::duration_cast<chrono::nanoseconds>(elapsed).count();
+            stats.samplesNs.push_back(static_cast<uint32_t>(min<long long>(ns, UINT32_MAX)));
+        }
+    }
+
+    vector<OperationStats> finish() {
+        for (auto& stats : operations) sort(stats.samplesNs.begin(), stats.samplesNs.end());
+        return move(operations);
+    }
+
+private:
+    size_t sampleEvery;
+    vector<OperationStats> operations;
+
+    OperationStats& find(const string& name) {
+        for (auto& stats : operations) {
+            if (stats.name == name) return stats;
+        }
+        operations.push_back(OperationStats());
+        operations.back().name = name;
+        return operations.back();
+    }
+};
+
+// ---- Workloads ----
+// Each drives a fresh, silent ParcelDeliverySystem with n parcels.
+
+struct Workload {
+    string name;
+    string description;
+    function<void(ParcelDeliverySystem&, Recorder&, size_t, mt19937&)> run;
+};
+
+string recipientFor(size_t i) { return "Recipient " + to_string(i); }
+string addressFor(size_t i) { return to_string(i % 9999 + 1) + " Benchmark Street"; }
+
+void lookupAndReport(ParcelDeliverySystem& system, Recorder& recorder, size_t n, mt19937& rng) {
+    uniform_int_distribution<int> anyId(1, static_cast<int>(n));
+    for (size_t i = 0; i < n; i++) {
+        int id = anyId(rng);
+        recorder.measure("searchParcelById", [&] { system.searchParcelById(id); });
+    }
+    for (int i = 0; i < 3; i++) {
+        recorder.measure("generateReports", [&] { system.generateReports(); });
+    }
+}
+
+vector<Workload> workloads() {
+    return {
+        {"sequential", "register all, search, load all, deliver all, report",
+         [](ParcelDeliverySystem& system, Recorder& recorder, size_t n, mt19937& rng) {
+             for (size_t i = 0; i < n; i++) {
+                 recorder.measure("registerParcel", [&] { system.registerParcel(recipientFor(i), addressFor(i), 1); });
+             }
+             for (size_t i = 0; i < n; i++) recorder.measure("loadParcels", [&] { system.loadParcels(); });
+             for (size_t i = 0; i < n; i++) recorder.measure("deliverParcel", [&] { system.deliverParcel(); });
+             lookupAndReport(system, recorder, n, rng);
+         }},
+        {"random-priority", "register with random priorities, interleaved with loads and deliveries",
+         [](ParcelDeliverySystem& system, Recorder& recorder, size_t n, mt19937& rng) {
+             uniform_int_distribution<int> priority(1, 10);
+             uniform_int_distribution<int> percent(0, 99);
+             size_t loaded = 0, delivered = 0;
+             for (size_t i = 0; i < n; i++) {
+                 int p = priority(rng);
+                 recorder.measure("registerParcel", [&] { system.registerParcel(recipientFor(i), addressFor(i), p); });
+                 if (percent(rng) < 60) {
+                     recorder.measure("loadParcels", [&] { system.loadParcels(); });
+                     loaded++;
+                 }
+                 if (delivered < loaded && percent(rng) < 40) {
+                     recorder.measure("deliverParcel", [&] { system.deliverParcel(); });
+                     delivered++;
+                 }
+             }
+             for (; loaded < n; loaded++) recorder.measure("loadParcels", [&] { system.loadParcels(); });
+             for (; delivered < n; delivered++) recorder.measure("deliverParcel", [&] { system.deliverParcel(); });
+             lookupAndReport(system, recorder, n, rng);
+         }},
+        {"undo-heavy", "register and load each parcel, undo both, redo both, then deliver",
+         [](ParcelDeliverySystem& system, Recorder& recorder, size_t n, mt19937& rng) {
+             for (size_t i = 0; i < n; i++) {
+                 recorder.measure("registerParcel", [&] { system.registerParcel(recipientFor(i), addressFor(i), 1); });
+                 recorder.measure("loadParcels", [&] { system.loadParcels(); });
+                 recorder.measure("undoLastAction", [&] { system.undoLastAction(); });
+                 recorder.measure("undoLastAction", [&] { system.undoLastAction(); });
+                 recorder.measure("redoLastAction", [&] { system.redoLastAction(); });
+                 recorder.measure("redoLastAction", [&] { system.redoLastAction(); });
+             }
+             for (size_t i = 0; i < n; i++) recorder.measure("deliverParcel", [&] { system.deliverParcel(); });
+             lookupAndReport(system, recorder, n, rng);
+         }},
+    };
+}
+
+// ---- Output ----
+
+string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void printResult(const RunResult& result) {
+    printf("\n%s, %zu parcels: %.3f s, peak heap %.1f MB, %s %.1f MB\n", result.workload.c_str(), result.parcels,
+           result.seconds, result.peakHeapBytes / 1048576.0,
+           result.residentIsProcessWide ? "process-wide peak RSS" : "peak RSS", result.peakResidentKb / 1024.0);
+    printf("  %-18s %12s %12s %10s %10s %10s %12s %10s\n", "operation", "calls", "ops/sec", "p50 ns", "p99 ns",
+           "p99.9 ns", "max ns", "allocs/op");
+    for (const auto& op : result.operations) {
+        printf("  %-18s %12zu %12.0f %10.0f %10.0f %10.0f %12.0f %10.2f\n", op.name.c_str(), op.calls,
+               op.seconds > 0 ? op.calls / op.seconds : 0.0, op.percentile(0.50), op.percentile(0.99),
+               op.percentile(0.999), op.percentile(1.0), op.calls ? double(op.allocations) / op.calls : 0.0);
+    }
+}
+
+// One entry of the JSON "runs" array
+string runJson(const RunResult& result) {
+    ostringstream out;
+    out << "    {\"workload\": \"" << result.workload << "\", \"parcels\": " << result.parcels
+        << ", \"seconds\": " << result.seconds << ", \"peakHeapBytes\": " << result.peakHeapBytes << ", \""
+        << (result.residentIsProcessWide ? "processPeakResidentKb" : "peakResidentKb") << "\": " << result.peakResidentKb
+        << ", \"operations\": [\n";
+    for (size_t i = 0; i < result.operations.size(); i++) {
+        const OperationStats& op = result.operations[i];
+        out << "      {\"name\": \"" << op.name << "\", \"calls\": " << op.calls << ", \"seconds\": " << op.seconds
+            << ", \"opsPerSec\": " << (op.seconds > 0 ? op.calls / op.seconds : 0)
+            << ", \"p50Ns\": " << op.percentile(0.50) << ", \"p90Ns\": " << op.percentile(0.90)
+            << ", \"p99Ns\": " << op.percentile(0.99) << ", \"p999Ns\": " << op.percentile(0.999)
+            << ", \"maxNs\": " << op.percentile(1.0) << ", \"allocations\": " << op.allocations << "}"
+            << (i + 1 < result.operations.size() ? ",\n" : "\n");
+    }
+    out << "    ]}";
+    return out.str();
+}
+
+void writeJson(const string& path, const vector<string>& runs) {
+    ofstream out(path);
+    out << "{\n  \"build\": {\"compiler\": \"" << jsonEscape(__VERSION__) << "\", \"optimized\": "
+#ifdef __OPTIMIZE__
+        << "true"
+#else
+        << "false"
+#endif
+        << ", \"date\": \"" << __DATE__ << "\"},\n  \"runs\": [\n";
+    for (size_t r = 0; r < runs.size(); r++) out << runs[r] << (r + 1 < runs.size() ? ",\n" : "\n");
+    out << "  ]\n}\n";
+}
+
+// Run one workload at one size in this process and print the result.
+// sharedProcess: earlier runs used this process too, so RSS is not this run's alone.
+RunResult runWorkload(const Workload& workload, size_t n, unsigned seed, bool sharedProcess) {
+    ostream silent(nullptr); // Discards everything the system prints
+    RunResult result;
+    result.workload = workload.name;
+    result.parcels = n;
+    result.residentIsProcessWide = sharedProcess;
+    Recorder recorder(max<size_t>(1, n / 1000000)); // keep about a million samples per operation
+    mt19937 rng(seed);
+    peakLiveBytes = liveBytes;
+    size_t baseBytes = liveBytes;
+    BenchClock::time_point start = BenchClock::now();
+    {
+        ParcelDeliverySystem system(silent);
+        workload.run(system, recorder, n, rng);
+    }
+    result.seconds = chrono::duration<double>(BenchClock::now() - start).count();
+    result.peakHeapBytes = peakLiveBytes - baseBytes;
+    result.peakResidentKb = peakResidentKb();
+    result.operations = recorder.finish();
+    printResult(result);
+    return result;
+}
+
+#ifndef _WIN32
+// Run one workload at one size in a child process, so its peak RSS is not
+// inherited from an earlier, larger run. The child prints its result and
+// sends back the run time and JSON entry. Returns false if the child failed.
+bool runIsolated(const Workload& workload, size_t n, unsigned seed, double& seconds, string& json) {
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    fflush(stdout);
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (child == 0) {
+        close(fds[0]);
+        RunResult result = runWorkload(workload, n, seed, false);
+        string message = to_string(result.seconds) + "\n" + runJson(result);
+        fflush(stdout);
+        bool sent = write(fds[1], message.data(), message.size()) == static_cast<ssize_t>(message.size());
+        _exit(sent ? 0 : 1);
+    }
+    close(fds[1]);
+    string message;
+    char buffer[4096];
+    ssize_t got;
+    while ((got = read(fds[0], buffer, sizeof(buffer))) > 0) message.append(buffer, static_cast<size_t>(got));
+    close(fds[0]);
+    int status = 0;
+    waitpid(child, &status, 0);
+    size_t newline = message.find('\n');
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || newline == string::npos) return false;
+    seconds = stod(message.substr(0, newline));
+    json = message.substr(newline + 1);
+    return true;
+}
+#endif
+
+void usage() {
+    cout << "Usage: parcelBenchmark [options]\n"
+         << "  --min N          smallest parcel count (default 1000)\n"
+         << "  --max N          largest parcel count, sizes grow 10x (default 1000000, up to 10000000)\n"
+         << "  --workload NAME  run only sequential, random-priority or undo-heavy\n"
+         << "  --budget SEC     skip a size if it is predicted to take longer than this (default 120)\n"
+         << "  --json PATH      also write results as JSON\n"
+         << "  --seed N         random seed (default 1)\n";
+}
+
+int main(int argc, char** argv) {
+    size_t minParcels = 1000, maxParcels = 1000000;
+    double budgetSeconds = 120;
+    string only, jsonPath;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--min" && hasValue) minParcels = stoull(argv[++i]);
+        else if (arg == "--max" && hasValue) maxParcels = stoull(argv[++i]);
+        else if (arg == "--workload" && hasValue) only = argv[++i];
+        else if (arg == "--budget" && hasValue) budgetSeconds = stod(argv[++i]);
+        else if (arg == "--json" && hasValue) jsonPath = argv[++i];
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned>(stoul(argv[++i]));
+        else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+    minParcels = max<size_t>(1, minParcels);
+
+    vector<string> runs; // JSON entries, in run order
+    for (const Workload& workload : workloads()) {
+        if (!only.empty() && workload.name != only) continue;
+        cout << "== " << workload.name << ": " << workload.description << " ==" << endl;
+        vector<pair<size_t, double>> timings; // (parcels, seconds) of earlier sizes
+        for (size_t n = minParcels; n <= maxParcels; n *= 10) {
+            // Predict this size from how the last two scaled and skip it if too slow
+            if (timings.size() >= 2) {
+                auto [n1, t1] = timings[timings.size() - 2];
+                auto [n2, t2] = timings.back();
+                double exponent = max(1.0, log(t2 / max(t1, 1e-9)) / log(double(n2) / n1));
+                double predicted = t2 * pow(double(n) / n2, exponent);
+                if (predicted > budgetSeconds) {
+                    printf("\n%s, %zu parcels: skipped, predicted %.0f s exceeds the %.0f s budget\n",
+                           workload.name.c_str(), n, predicted, budgetSeconds);
+                    break;
+                }
+            }
+
+            double seconds = 0;
+            string json;
+#ifdef _WIN32
+            // No fork(): every run shares this process, so RSS is a process-wide high-water mark
+            RunResult result = runWorkload(workload, n, seed, true);
+            seconds = result.seconds;
+            json = runJson(result);
+#else
+            if (!runIsolated(workload, n, seed, seconds, json)) {
+                printf("\n%s, %zu parcels: the run failed or ran out of memory\n", workload.name.c_str(), n);
+                break;
+            }
+#endif
+            runs.push_back(json);
+            timings.push_back({n, seconds});
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        writeJson(jsonPath, runs);
+        cout << "\nResults written to " << jsonPath << endl;
+    }
+    return 0;
+}
@@ -1,225 +1,97 @@
+#include <exception>
 #include <iostream>
 #include <string>
-#include <queue>
-#include <stack>
-#include <list>
-#include <algorithm>
 #include <limits> // for validation
+#include "parcelDeliverySystem.h"
+#include "depotSimulation.h"
 
 using namespace std;
 
-// Parcel structure
-struct Parcel {
-    int id;
-    string recipient;
-    string address;
-    int priority; // Lower number means higher priority
-};
-
-// Comparator for priority queue
-struct ComparePriority {
-    bool operator()(Parcel const& p1, Parcel const& p2) {
-        return p1.priority > p2.priority; // Higher priority parcels come first
-    }
-};
-
-// Node for Binary Search Tree
-struct BSTNode {
-    Parcel parcel;
-    BSTNode* left;
-    BSTNode* right;
-
-    BSTNode(Parcel p) : parcel(p), left(nullptr), right(nullptr) {}
-};
-
-// Class for the Parcel Delivery System
-class ParcelDeliverySystem {
-private:
-    list<Parcel> parcelList;
-    priority_queue<Parcel, vector<Parcel>, ComparePriority> priorityQueue;
-    queue<Parcel> loadingQueue;
-    list<Parcel> deliveredParcels;
-    stack<pair<string, Parcel>> actionStack; // Stack for undo actions
-    stack<pair<string, Parcel>> redoStack; // Stack for redo actions
-    BSTNode* root;
-    int totalDelivered;
-    int nextParcelId; // To keep track of the next parcel ID
-
-    // function to insert into BST
-    BSTNode* insertBST(BSTNode* node, Parcel parcel) {
-        if (node == nullptr) {
-            return new BSTNode(parcel);
-        }
-        if (parcel.id < node->parcel.id) {
-            node->left = insertBST(node->left, parcel);
-        } else {
-            node->right = insertBST(node->right, parcel);
-        }
-        return node;
-    }
-
-    // function to search in BST
-    BSTNode* searchBST(BSTNode* node, int id) {
-        if (node == nullptr || node->parcel.id == id) {
-            return node;
-        }
-        if (id < node->parcel.id) {
-            return searchBST(node->left, id);
-        }
-        return searchBST(node->right, id);
-    }
-
-public:
-    ParcelDeliverySystem() : root(nullptr), totalDelivered(0), nextParcelId(1) {}
-
-    // Register a parcel
-    void registerParcel(string recipient, string address, int priority) {
-        Parcel parcel = {nextParcelId++, recipient, address, priority};
-        parcelList.push_back(parcel);
-        priorityQueue.push(parcel);
-        root = insertBST(root, parcel);
-        actionStack.push({"register", parcel}); // Record action for undo
-        while (!redoStack.empty()) redoStack.pop(); // Clear redo stack on new action
-        cout << "Parcel registered: ID " << parcel.id << endl;
-    }
-
-    // Load parcel one by one unto delivery truck
-    void loadParcels() {
-        if (!parcelList.empty()) {
-            Parcel parcel = parcelList.front();
-            parcelList.pop_front(); // Remove from the list
-            loadingQueue.push(parcel); // Add to the loading queue
-            actionStack.push({"load", parcel}); // Record the action for undo
-            while (!redoStack.empty()) redoStack.pop(); // Clear redo stack on new action
-            cout << "Parcel loaded onto the truck: ID " << parcel.id << endl;
+// Read a whole number in [minimum, maximum], re-prompting on bad input
+int readNumber(const string& prompt, int minimum, int maximum = numeric_limits<int>::max()) {
+    int value;
+    cout << prompt;
+    while (!(cin >> value) || value < minimum || value > maximum) {
+        if (maximum == numeric_limits<int>::max()) {
+            cout << "Invalid input. Please enter a number of at least " << minimum << ": ";
         } else {
-            cout << "No parcels left to load." << endl;
+            cout << "Invalid input. Please enter a number between " << minimum << " and " << maximum << ": ";
         }
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
     }
+    return value;
+}
 
-    // Deliver a parcel based on priority
-    void deliverParcel() {
-        if (!loadingQueue.empty()) {
-            Parcel parcel = loadingQueue.front();
-            loadingQueue.pop(); // Remove from the loading queue
-            deliveredParcels.push_back(parcel); // Add to delivered parcels list
-            totalDelivered++;
-            cout << "Delivered Parcel ID: " << parcel.id << " (Priority: " << parcel.priority << ")" << endl;
+// Read a decimal number (coordinates and distances in km), re-prompting on bad
+// input. Values are limited to the area the location grid covers.
+double readKm(const string& prompt, bool allowNegative) {
+    const double limit = SpatialGrid::maxCoordinateKm;
+    double value;
+    cout << prompt;
+    while (!(cin >> value) || !(value >= (allowNegative ? -limit : 0) && value <= limit)) {
+        if (allowNegative) {
+            cout << "Invalid input. Please enter a number between " << -limit << " and " << limit << ": ";
         } else {
-            cout << "No parcels to deliver." << endl;
+            cout << "Invalid input. Please enter a distance between 0 and " << limit << ": ";
         }
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
     }
+    return value;
+}
 
-    // Search for a parcel by ID
-    void searchParcelById(int id) {
-        BSTNode* result = searchBST(root, id);
-        if (result) {
-            cout << "Parcel found: ID: " << result->parcel.id << ", Recipient: " << result->parcel.recipient << endl;
-        } else {
-            cout << "Parcel not found." << endl;
-        }
+// Ask which area to look in and list the parcels there
+void trackParcelsByLocation(ParcelDeliverySystem& system) {
+    cout << "1. Parcels near the depot\n";
+    cout << "2. Parcels near the truck\n";
+    cout << "3. Parcels inside an area\n";
+    int mode = readNumber("Choose a search: ", 1);
+    while (mode > 3) {
+        mode = readNumber("Please enter 1, 2 or 3: ", 1);
     }
-
-    // Undo last action
-    void undoLastAction() {
-        if (!actionStack.empty()) {
-            auto lastAction = actionStack.top();
-            actionStack.pop();
-            redoStack.push(lastAction); // Push to redo stack
-
-            if (lastAction.first == "register") {
-                // Undo registration
-                parcelList.remove_if([&](const Parcel& p) { return p.id == lastAction.second.id; });
-                priorityQueue = priority_queue<Parcel, vector<Parcel>, ComparePriority>(); // Rebuild priority queue
-                for (const auto& p : parcelList) {
-                    priorityQueue.push(p);
-                }
-                root = nullptr; // Rebuild BST
-                for (const auto& p : parcelList) {
-                    root = insertBST(root, p);
-                }
-                cout << "Undid registration for Parcel ID: " << lastAction.second.id << endl;
-            } else if (lastAction.first == "load") {
-                // Undo loading
-                if (!loadingQueue.empty() && loadingQueue.back().id == lastAction.second.id) {
-                    loadingQueue.pop(); // Remove from loading queue
-                    parcelList.push_front(lastAction.second); // Re-add to parcelList
-                    cout << "Undid loading for Parcel ID: " << lastAction.second.id << endl;
-                }
-            }
-        } else {
-            cout << "No actions to undo." << endl;
-        }
+    if (mode == 1) {
+        system.trackNearDepot(readKm("Within how many km of the depot? ", false));
+    } else if (mode == 2) {
+        system.trackNearTruck(readKm("Within how many km of the truck? ", false));
+    } else {
+        double x1 = readKm("First corner, km east of the depot: ", true);
+        double y1 = readKm("First corner, km north of the depot: ", true);
+        double x2 = readKm("Opposite corner, km east of the depot: ", true);
+        double y2 = readKm("Opposite corner, km north of the depot: ", true);
+        system.trackInArea(x1, y1, x2, y2);
     }
+}
 
-    // Redo last undone action aided by AI
-    void redoLastAction() {
-        if (!redoStack.empty()) {
-            auto lastUndone = redoStack.top();
-            redoStack.pop();
-            actionStack.push(lastUndone); // Push back to action stack
-
-            if (lastUndone.first == "register") {
-                // Redo registration
-                parcelList.push_back(lastUndone.second);
-                priorityQueue.push(lastUndone.second);
-                root = insertBST(root, lastUndone.second);
-                cout << "Redid registration for Parcel ID: " << lastUndone.second.id << endl;
-            } else if (lastUndone.first == "load") {
-                // Redo loading
-                loadingQueue.push(lastUndone.second); // Re-add to loading queue
-                parcelList.remove_if([&](const Parcel& p) { return p.id == lastUndone.second.id; });
-                cout << "Redid loading for Parcel ID: " << lastUndone.second.id << endl;
-            }
-        } else {
-            cout << "No actions to redo." << endl;
-        }
-    }
-
-    // Generate reports
-    void generateReports() {
-
-        cout << "Total parcels delivered: " << totalDelivered << endl;
-        // Delivered parcels
-        cout << "Delivered parcels:\n";
-        for (const auto& parcel : deliveredParcels) {
-            cout << "ID: " << parcel.id << ", Recipient: " << parcel.recipient << endl;
-        };
-        // Parcels pending delivery by priority aided by AI
-            cout << "Parcels pending delivery by priority:\n";
-            vector<Parcel> pendingParcels;
-            queue<Parcel> tempQueue = loadingQueue;
-            while (!tempQueue.empty()) {
-                pendingParcels.push_back(tempQueue.front());
-                tempQueue.pop();
-            }
-            sort(pendingParcels.begin(), pendingParcels.end(), [](const Parcel& p1, const Parcel& p2) {
-                return p1.priority < p2.priority;
-            });
-            for (const auto& parcel : pendingParcels) {
-                cout << "ID: " << parcel.id << ", Priority: " << parcel.priority << endl;
-            }
-
-            // Delivery routes used
-           cout << "Delivery routes used (order of delivery as entered):\n";
-            if (!deliveredParcels.empty()) {
-                auto it = deliveredParcels.begin();
-                cout << "ID: " << it->id;
-                ++it;
-                for (; it != deliveredParcels.end(); ++it) {
-                    cout << " - ID: " << it->id;
-                }
-                cout << endl;
-            } else {
-                cout << "No delivery routes used." << endl;
-            }    
+// Drive the register -> load -> deliver pipeline, backed by a ParcelDeliverySystem, with a synthetic workload
+void runDepotSimulation() {
+    SimulationConfig config;
+    config.parcels = readNumber("Number of parcels to simulate: ", 1, static_cast<int>(SimulationConfig::maxParcels));
+    config.producers = readNumber("Number of registration desks (threads): ", 1, SimulationConfig::maxProducers);
+    config.arrivalRate = readNumber("Arrivals per second (0 = as fast as possible): ", 0);
+    config.registerMicros = readNumber("Extra handling time per registration in microseconds: ", 0);
+    config.loadMicros = readNumber("Extra handling time per load in microseconds: ", 0);
+    config.deliverMicros = readNumber("Extra handling time per delivery in microseconds: ", 0);
+    cout << "Running simulation: each stage calls the real register, load and deliver code on one shared, "
+            "unlogged system, plus the handling time above..." << endl;
+    try {
+        DepotSimulation(config).run().print(cout);
+    } catch (const exception& error) {
+        cout << "The simulation could not run (" << error.what() << "). Try fewer parcels or desks." << endl;
     }
-};
+}
 
 int main() {
     ParcelDeliverySystem system;
-    int choice, priority, id;
-    string recipient, address;
+    system.setHistorySpillFile("delivered_history.bin", 100000); // The delivered history keeps at most 100k rows in memory
+    if (!system.enablePersistence("parcels.wal", "parcels.snapshot")) {
+        // Carrying on would write over the files the previous session is in
+        cout << "Could not restore the previous session from parcels.snapshot, parcels.wal and "
+                "delivered_history.bin.\nMove or repair those files and start the program again." << endl;
+        return 1;
+    }
+    int choice, priority, id, minutes;
+    string recipient, address, query;
 
     do {
         cout << "\nParcel Delivery System Menu:\n";
@@ -230,12 +102,18 @@ int main() {
         cout << "5. Generate Reports\n";
         cout << "6. Undo Last Action\n";
         cout << "7. Redo Last Action\n";
-        cout << "8. Exit\n";
+        cout << "8. Search Parcels by Recipient/Address\n";
+        cout << "9. View Recent Deliveries\n";
+        cout << "10. Run Depot Simulation\n";
+        cout << "11. Move Truck\n";
+        cout << "12. Track Parcels by Location\n";
+        cout << "13. Load All Parcels\n";
+        cout << "14. Exit\n";
         cout << "Enter your choice: ";
 
         // Validate menu choice
-        while (!(cin >> choice) || choice < 1 || choice > 8) {
-            cout << "Invalid input. Please enter a number between 1 and 8: ";
+        while (!(cin >> choice) || choice < 1 || choice > 14) {
+            cout << "Invalid input. Please enter a number between 1 and 14: ";
             cin.clear(); // Clear error state
             cin.ignore(numeric_limits<streamsize>::max(), '\n'); // Ignore invalid input
         }
@@ -300,13 +178,55 @@ int main() {
                 break;
 
             case 8:
+                cout << "Enter recipient name or address (or part of it): ";
+                getline(cin, query);
+                while (query.empty()) {
+                    cout << "Search text cannot be empty. Please enter a name or address: ";
+                    getline(cin, query);
+                }
+
+                system.searchParcels(query);
+                break;
+
+            case 9:
+                cout << "Show deliveries from the last how many minutes? ";
+                while (!(cin >> minutes) || minutes < 1) {
+                    cout << "Invalid input. Please enter a positive number of minutes: ";
+                    cin.clear();
+                    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+                }
+
+                system.viewRecentDeliveries(minutes);
+                break;
+
+            case 10:
+                runDepotSimulation();
+                break;
+
+            case 11: {
+                double x = readKm("Truck position, km east of the depot: ", true);
+                double y = readKm("Truck position, km north of the depot: ", true);
+                system.moveTruck(x, y);
+                break;
+            }
+
+            case 12:
+                trackParcelsByLocation(system);
+                break;
+
+            case 13:
+                system.loadAllParcels();
+                break;
+
+            case 14:
+                system.checkpoint();
                 cout << "Exiting the system." << endl;
                 break;
 
             default:
                 cout << "Invalid choice. Please try again." << endl;
         }
-    } while (choice != 8);
+    } while (choice != 14);
 
     return 0;
 }
@@ -0,0 +1,746 @@
+#ifndef PARCEL_DELIVERY_SYSTEM_H
+#define PARCEL_DELIVERY_SYSTEM_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <queue>
+#include <deque>
+#include <list>
+#include <set>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include "parcel.h"
+#include "parcelSearchIndex.h"
+#include "deliveredHistory.h"
+#include "writeAheadLog.h"
+#include "spatialGrid.h"
+#include "undoHistory.h"
+#include "../Shared/orderedIndex.h"
+
+// Class for the Parcel Delivery System
+class ParcelDeliverySystem {
+private:
+    std::list<Parcel> parcelList;
+    std::priority_queue<Parcel, std::vector<Parcel>, ComparePriority> priorityQueue;
+    std::deque<Parcel> loadingQueue; // Truck contents; undoing a load takes the parcel back off the end
+    std::multiset<std::pair<int, int>> pendingByPriority; // (priority, id) of every truck entry, kept sorted for reports
+    DeliveredHistory deliveredParcels; // Columnar, append-only record of deliveries
+    UndoHistory history; // The last 10,000 undoable actions, 8 bytes each
+    std::unordered_map<int, Parcel> cancelledParcels; // Undone registrations that can still be redone
+    OrderedIndex<int, Parcel> parcelsById; // Every registered parcel, for search by ID
+    ParcelSearchIndex searchIndex; // Recipient/address search across all parcel states
+    SpatialGrid parcelLocations; // Parcels at the depot or delivered; loaded parcels ride with the truck
+    Position depotPosition; // The depot is the origin of the map
+    Position truckPosition;
+    int nextParcelId; // To keep track of the next parcel ID
+    WriteAheadLog wal; // Durable record of every action since the last snapshot
+    std::string snapshotPath;
+    uint64_t lastLsn = 0; // Sequence number of the last logged action
+    uint64_t snapshotLogBytes = 4 << 20; // Smallest log that triggers a snapshot
+    uint64_t lastSnapshotBytes = 0;
+    bool replaying = false; // Set while recovery re-applies logged actions
+    std::ostream& output; // Where messages are printed
+
+    // Append an action to the log before it is carried out. Returns false if the
+    // log could not be written, in which case the action must not be applied.
+    bool logAction(WalRecord::Type type, const Parcel& parcel, int64_t when = 0) {
+        WalRecord record;
+        record.type = type;
+        record.id = parcel.id;
+        record.priority = parcel.priority;
+        record.time = when;
+        if (type == WalRecord::Register) {
+            record.recipient = parcel.recipient;
+            record.address = parcel.address;
+        }
+        return appendLog(record);
+    }
+
+    bool appendLog(WalRecord& record) {
+        if (replaying || snapshotPath.empty()) return true;
+        record.lsn = lastLsn + 1;
+        if (!wal.append(record)) return false;
+        lastLsn++;
+        return true;
+    }
+
+    void reportLogFailure(const std::string& action) {
+        output << "Could not write to the parcel log; " << action << ".\n";
+    }
+
+    // Snapshot once the log has grown past both snapshotLogBytes and the last
+    // snapshot, so snapshot writes never outweigh log writes and recovery replays
+    // a bounded log. Called after an action is applied, so the snapshot always
+    // includes every logged action.
+    void checkpointIfDue() {
+        if (!replaying && !snapshotPath.empty() && wal.size() >= std::max(snapshotLogBytes, lastSnapshotBytes)) {
+            checkpoint();
+        }
+    }
+
+    void deliverParcelAt(int64_t when) {
+        if (!loadingQueue.empty()) {
+            Parcel parcel = loadingQueue.front();
+            if (!logAction(WalRecord::Deliver, parcel, when)) {
+                reportLogFailure("parcel not delivered");
+                return;
+            }
+            loadingQueue.pop_front(); // Remove from the loading queue
+            pendingByPriority.erase(pendingByPriority.find({parcel.priority, parcel.id}));
+            deliveredParcels.append(parcel.id, parcel.priority, parcel.recipient, parcel.address, when,
+                                    truckPosition.x, truckPosition.y);
+            searchIndex.setStatus(parcel.id, ParcelStatus::Delivered);
+            parcelLocations.upsert(parcel.id, truckPosition); // Left where the truck dropped it
+            output << "Delivered Parcel ID: " << parcel.id << " (Priority: " << parcel.priority << ")\n";
+            checkpointIfDue();
+        } else {
+            output << "No parcels to deliver.\n";
+        }
+    }
+
+    static void writeParcel(ByteWriter& out, const Parcel& parcel) {
+        out.i32(parcel.id);
+        out.str(parcel.recipient);
+        out.str(parcel.address);
+        out.i32(parcel.priority);
+    }
+
+    static Parcel readParcel(ByteReader& in) {
+        Parcel parcel;
+        parcel.id = in.i32();
+        parcel.recipient = in.str();
+        parcel.address = in.str();
+        parcel.priority = in.i32();
+        return parcel;
+    }
+
+    void writeHistory(ByteWriter& out) {
+        out.u32(static_cast<uint32_t>(history.size()));
+        out.u32(static_cast<uint32_t>(history.undoCount()));
+        out.u8(history.inGroup());
+        out.u8(history.linksNext());
+        for (size_t i = 0; i < history.size(); i++) {
+            const UndoEntry& entry = history.entry(i);
+            out.u8(entry.op);
+            out.u8(entry.flags);
+            out.i32(entry.parcelId);
+        }
+        out.u32(static_cast<uint32_t>(cancelledParcels.size()));
+        for (const auto& [id, parcel] : cancelledParcels) writeParcel(out, parcel);
+    }
+
+    void readHistory(ByteReader& in) {
+        uint32_t count = in.u32();
+        uint32_t undoCount = in.u32();
+        bool inGroup = in.u8();
+        bool linkNext = in.u8();
+        std::vector<UndoEntry> entries;
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            UndoEntry entry;
+            entry.op = static_cast<UndoEntry::Op>(in.u8());
+            entry.flags = in.u8();
+            entry.parcelId = in.i32();
+            entries.push_back(entry);
+        }
+        history.assign(entries, undoCount, inGroup, linkNext);
+        count = in.u32();
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            Parcel parcel = readParcel(in);
+            cancelledParcels[parcel.id] = parcel;
+        }
+    }
+
+    // Record an action for undo; actions that could have been redone are forgotten
+    void recordAction(UndoEntry::Op op, int id) {
+        history.record(op, id, [&](const UndoEntry& dropped) {
+            if (dropped.op == UndoEntry::Register) cancelledParcels.erase(dropped.parcelId);
+        });
+    }
+
+    // Take a waiting parcel out of the list. Undo and redo work at its ends, so check those first.
+    bool takeWaiting(int id, Parcel& parcel) {
+        auto it = parcelList.end();
+        if (!parcelList.empty() && parcelList.back().id == id) {
+            it = std::prev(parcelList.end());
+        } else if (!parcelList.empty() && parcelList.front().id == id) {
+            it = parcelList.begin();
+        } else {
+            it = std::find_if(parcelList.begin(), parcelList.end(), [&](const Parcel& p) { return p.id == id; });
+        }
+        if (it == parcelList.end()) return false;
+        parcel = *it;
+        parcelList.erase(it);
+        return true;
+    }
+
+    void undoEntry(const UndoEntry& entry) {
+        Parcel parcel;
+        if (entry.op == UndoEntry::Register) {
+            // Undo registration
+            if (!takeWaiting(entry.parcelId, parcel)) {
+                output << "Parcel ID " << entry.parcelId << " has already left the depot; registration kept.\n";
+                return;
+            }
+            priorityQueue = std::priority_queue<Parcel, std::vector<Parcel>, ComparePriority>(); // Rebuild priority queue
+            for (const auto& p : parcelList) {
+                priorityQueue.push(p);
+            }
+            parcelsById.erase(parcel.id);
+            searchIndex.remove(parcel.id);
+            parcelLocations.remove(parcel.id);
+            cancelledParcels[parcel.id] = parcel; // Kept while the registration can be redone
+            output << "Undid registration for Parcel ID: " << parcel.id << "\n";
+        } else if (entry.op == UndoEntry::Load) {
+            // Undo loading
+            if (loadingQueue.empty() || loadingQueue.back().id != entry.parcelId) {
+                output << "Parcel ID " << entry.parcelId << " is no longer on the truck; nothing to unload.\n";
+                return;
+            }
+            parcel = loadingQueue.back();
+            loadingQueue.pop_back(); // Remove from loading queue
+            pendingByPriority.erase(pendingByPriority.find({parcel.priority, parcel.id}));
+            parcelList.push_front(parcel); // Re-add to parcelList
+            searchIndex.setStatus(parcel.id, ParcelStatus::Registered);
+            parcelLocations.upsert(parcel.id, depotPosition);
+            output << "Undid loading for Parcel ID: " << parcel.id << "\n";
+        }
+    }
+
+    void redoEntry(const UndoEntry& entry) {
+        Parcel parcel;
+        if (entry.op == UndoEntry::Register) {
+            // Redo registration
+            auto cancelled = cancelledParcels.find(entry.parcelId);
+            if (cancelled == cancelledParcels.end()) {
+                output << "Registration of Parcel ID " << entry.parcelId << " was kept; nothing to redo.\n";
+                return;
+            }
+            parcel = cancelled->second;
+            cancelledParcels.erase(cancelled);
+            parcelList.push_back(parcel);
+            priorityQueue.push(parcel);
+            parcelsById.insert(parcel.id, parcel);
+            searchIndex.add(parcel.id, parcel.recipient, parcel.address, ParcelStatus::Registered);
+            parcelLocations.upsert(parcel.id, depotPosition);
+            output << "Redid registration for Parcel ID: " << parcel.id << "\n";
+        } else if (entry.op == UndoEntry::Load) {
+            // Redo loading
+            if (!takeWaiting(entry.parcelId, parcel)) {
+                output << "Parcel ID " << entry.parcelId << " is not waiting at the depot; nothing to load.\n";
+                return;
+            }
+            loadingQueue.push_back(parcel); // Re-add to loading queue
+            pendingByPriority.insert({parcel.priority, parcel.id});
+            searchIndex.setStatus(parcel.id, ParcelStatus::Loaded);
+            parcelLocations.remove(parcel.id);
+            output << "Redid loading for Parcel ID: " << parcel.id << "\n";
+        }
+    }
+
+    bool logStep(WalRecord::Type type) {
+        WalRecord record;
+        record.type = type;
+        return appendLog(record);
+    }
+
+    std::vector<std::pair<int, Position>> collectWithin(Position centre, double radiusKm) {
+        std::vector<std::pair<int, Position>> found;
+        parcelLocations.forEachWithin(centre, radiusKm, [&](int id, Position pos) { found.push_back({id, pos}); });
+        if (distanceKm(truckPosition, centre) <= radiusKm) {
+            for (const auto& p : loadingQueue) found.push_back({p.id, truckPosition});
+        }
+        return found;
+    }
+
+    // Print the closest 20 tracked parcels to centre. Distances are worked out
+    // once, and only the 20 shown are sorted.
+    void printTracked(const std::vector<std::pair<int, Position>>& found, Position centre) {
+        if (found.empty()) {
+            output << "No parcels in that area.\n";
+            return;
+        }
+        std::vector<std::pair<double, size_t>> byDistance; // (distance, index into found)
+        byDistance.reserve(found.size());
+        for (size_t i = 0; i < found.size(); i++) byDistance.push_back({distanceKm(found[i].second, centre), i});
+        size_t shown = std::min<size_t>(20, found.size());
+        std::partial_sort(byDistance.begin(), byDistance.begin() + shown, byDistance.end(),
+                          [&](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+                              if (a.first != b.first) return a.first < b.first;
+                              return found[a.second].first < found[b.second].first;
+                          });
+        output << found.size() << " parcel(s) found" << (found.size() > 20 ? ", closest 20 shown" : "") << ":\n";
+        for (size_t i = 0; i < shown; i++) {
+            const auto& [id, pos] = found[byDistance[i].second];
+            const ParcelSearchIndex::Entry* entry = searchIndex.find(id);
+            output << "ID: " << id << ", Recipient: " << (entry ? entry->recipient : "?")
+                 << ", Status: " << (entry ? statusName(entry->status) : "?") << ", Location: (" << pos.x << ", "
+                 << pos.y << ") km, Distance: " << byDistance[i].first << " km\n";
+        }
+    }
+
+    // Parcels still in play, the undo history, and the delivered history's
+    // segment list. Delivered rows already in the spill file are not rewritten,
+    // and the ID, search and location indexes are rebuilt on restore.
+    std::string encodeSnapshot() {
+        ByteWriter out;
+        out.u64(lastLsn);
+        out.i32(nextParcelId);
+        out.f64(truckPosition.x);
+        out.f64(truckPosition.y);
+        deliveredParcels.saveState(out);
+        out.u32(static_cast<uint32_t>(parcelList.size()));
+        for (const auto& p : parcelList) writeParcel(out, p);
+        out.u32(static_cast<uint32_t>(loadingQueue.size()));
+        for (const auto& p : loadingQueue) writeParcel(out, p);
+        writeHistory(out);
+        return out.data;
+    }
+
+    // Back to a new, empty system, as after a failed recovery. Persistence
+    // settings and the spill file are kept.
+    void clearState() {
+        parcelList.clear();
+        priorityQueue = std::priority_queue<Parcel, std::vector<Parcel>, ComparePriority>();
+        loadingQueue.clear();
+        pendingByPriority.clear();
+        deliveredParcels.clear();
+        history = UndoHistory();
+        cancelledParcels.clear();
+        parcelsById.clear();
+        searchIndex = ParcelSearchIndex();
+        parcelLocations = SpatialGrid();
+        truckPosition = Position();
+        nextParcelId = 1;
+        lastLsn = 0;
+        lastSnapshotBytes = 0;
+    }
+
+    // Rebuild every in-memory structure from a snapshot (system must be empty)
+    bool restoreSnapshot(const std::string& data) {
+        ByteReader in(data);
+        lastLsn = in.u64();
+        nextParcelId = in.i32();
+        truckPosition.x = in.f64();
+        truckPosition.y = in.f64();
+        if (!deliveredParcels.restoreState(in)) return false;
+        deliveredParcels.forEach([&](const DeliveryRecord& parcel) {
+            parcelsById.insert(parcel.id, Parcel{parcel.id, parcel.recipient, parcel.address, parcel.priority});
+            searchIndex.add(parcel.id, parcel.recipient, parcel.address, ParcelStatus::Delivered);
+            Position pos;
+            pos.x = parcel.x;
+            pos.y = parcel.y;
+            parcelLocations.upsert(parcel.id, pos);
+        });
+        uint32_t count = in.u32();
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            Parcel parcel = readParcel(in);
+            parcelList.push_back(parcel);
+            priorityQueue.push(parcel);
+            parcelsById.insert(parcel.id, parcel);
+            searchIndex.add(parcel.id, parcel.recipient, parcel.address, ParcelStatus::Registered);
+            parcelLocations.upsert(parcel.id, depotPosition);
+        }
+        count = in.u32();
+        for (uint32_t i = 0; i < count && in.ok(); i++) {
+            Parcel parcel = readParcel(in);
+            loadingQueue.push_back(parcel);
+            pendingByPriority.insert({parcel.priority, parcel.id});
+            parcelsById.insert(parcel.id, parcel);
+            searchIndex.add(parcel.id, parcel.recipient, parcel.address, ParcelStatus::Loaded);
+        }
+        readHistory(in);
+        return in.ok() && in.atEnd();
+    }
+
+    void replay(const WalRecord& record) {
+        switch (record.type) {
+            case WalRecord::Register:
+                nextParcelId = record.id;
+                registerParcel(record.recipient, record.address, record.priority);
+                break;
+            case WalRecord::Load:
+                loadParcels();
+                break;
+            case WalRecord::Deliver:
+                deliverParcelAt(record.time);
+                break;
+            case WalRecord::Undo:
+                undoLastAction();
+                break;
+            case WalRecord::Redo:
+                redoLastAction();
+                break;
+            case WalRecord::MoveTruck:
+                moveTruck(record.x, record.y);
+                break;
+            case WalRecord::BeginTransaction:
+                beginTransaction();
+                break;
+            case WalRecord::CommitTransaction:
+                commitTransaction();
+                break;
+        }
+    }
+
+public:
+    // Messages go to cout unless another stream is given (the benchmark passes a silent one)
+    ParcelDeliverySystem(std::ostream& output = std::cout) : nextParcelId(1), output(output) {}
+
+    // Write delivered parcels to disk in batches instead of keeping them all in memory
+    bool setHistorySpillFile(const std::string& path, size_t rowsPerSegment) {
+        return deliveredParcels.setSpillFile(path, rowsPerSegment);
+    }
+
+    // Recover the previous session from snapshotFile and logFile, then log every
+    // action from now on. With recordsPerCommit > 1 fsyncs are batched (group
+    // commit) and only actions covered by flushLog() or a full batch are durable.
+    // A snapshot is taken once the log reaches logBytesPerSnapshot (or the size
+    // of the last snapshot, if larger). Set the history spill file first: the
+    // snapshot refers to the delivered parcels already written there.
+    // Returns false, leaving the system empty and every file as it was, if the
+    // previous session can't be recovered; nothing is logged then.
+    bool enablePersistence(const std::string& logFile, const std::string& snapshotFile, size_t recordsPerCommit = 1,
+                           uint64_t logBytesPerSnapshot = 4 << 20) {
+        snapshotLogBytes = std::max<uint64_t>(1, logBytesPerSnapshot);
+
+        std::string data;
+        if (readChecksummedFile(snapshotFile, data)) {
+            if (!restoreSnapshot(data)) {
+                clearState();
+                return false;
+            }
+            lastSnapshotBytes = data.size();
+        } else if (std::filesystem::exists(snapshotFile)) {
+            return false; // A damaged snapshot must not be silently replaced by a partial log replay
+        }
+
+        std::vector<WalRecord> records;
+        if (!wal.open(logFile, records, recordsPerCommit)) {
+            clearState();
+            return false;
+        }
+        if (!deliveredParcels.resumeSpillFile()) {
+            wal.close();
+            clearState();
+            return false;
+        }
+        snapshotPath = snapshotFile; // Actions are logged from here on
+
+        replaying = true;
+        output.setstate(std::ios::failbit); // Keep replayed actions off the console
+        for (const auto& record : records) {
+            if (record.lsn <= lastLsn) continue; // Already covered by the snapshot
+            replay(record);
+            lastLsn = record.lsn;
+        }
+        output.clear();
+        replaying = false;
+        commitTransaction(); // A transaction cut off by a crash keeps what it had done as one action
+
+        if (!parcelList.empty() || !loadingQueue.empty() || deliveredParcels.size() > 0) {
+            output << "Recovered previous session: " << parcelList.size() << " waiting, " << loadingQueue.size()
+                 << " loaded, " << deliveredParcels.size() << " delivered.\n";
+        }
+        return true;
+    }
+
+    // Make every logged action durable
+    bool flushLog() {
+        return wal.commit();
+    }
+
+    // Sequence number of the last logged action (0 without persistence)
+    uint64_t lastLogSequence() const {
+        return lastLsn;
+    }
+
+    // Parcels registered and not yet loaded
+    size_t waitingCount() const {
+        return parcelList.size();
+    }
+
+    // Write a snapshot and start a fresh log. Delivered parcels are flushed to
+    // the spill file first so the snapshot only has to list its segments.
+    bool checkpoint() {
+        if (!wal.isOpen() || !wal.commit() || !deliveredParcels.flush()) return false;
+        std::string snapshot = encodeSnapshot();
+        if (!writeChecksummedFile(snapshotPath, snapshot)) return false;
+        lastSnapshotBytes = snapshot.size();
+        return wal.reset();
+    }
+
+    // Register a parcel
+    void registerParcel(std::string recipient, std::string address, int priority) {
+        Parcel parcel = {nextParcelId, recipient, address, priority};
+        if (!logAction(WalRecord::Register, parcel)) {
+            reportLogFailure("parcel not registered");
+            return;
+        }
+        nextParcelId++;
+        parcelList.push_back(parcel);
+        priorityQueue.push(parcel);
+        parcelsById.insert(parcel.id, parcel);
+        searchIndex.add(parcel.id, parcel.recipient, parcel.address, ParcelStatus::Registered);
+        parcelLocations.upsert(parcel.id, depotPosition);
+        recordAction(UndoEntry::Register, parcel.id); // Record action for undo
+        output << "Parcel registered: ID " << parcel.id << "\n";
+        checkpointIfDue();
+    }
+
+    // Load parcel one by one unto delivery truck. Returns false if nothing was loaded.
+    bool loadParcels() {
+        if (!parcelList.empty()) {
+            Parcel parcel = parcelList.front();
+            if (!logAction(WalRecord::Load, parcel)) {
+                reportLogFailure("parcel not loaded");
+                return false;
+            }
+            parcelList.pop_front(); // Remove from the list
+            loadingQueue.push_back(parcel); // Add to the loading queue
+            pendingByPriority.insert({parcel.priority, parcel.id});
+            searchIndex.setStatus(parcel.id, ParcelStatus::Loaded);
+            parcelLocations.remove(parcel.id); // Now tracked through the truck
+            recordAction(UndoEntry::Load, parcel.id); // Record the action for undo
+            output << "Parcel loaded onto the truck: ID " << parcel.id << "\n";
+            checkpointIfDue();
+            return true;
+        }
+        output << "No parcels left to load.\n";
+        return false;
+    }
+
+    // Deliver a parcel based on priority
+    void deliverParcel() {
+        deliverParcelAt(std::time(nullptr));
+    }
+
+    // Search for a parcel by ID
+    void searchParcelById(int id) {
+        const Parcel* result = parcelsById.find(id);
+        if (result) {
+            output << "Parcel found: ID: " << result->id << ", Recipient: " << result->recipient << "\n";
+        } else {
+            output << "Parcel not found.\n";
+        }
+    }
+
+    // Search for parcels by recipient or address (substring, with fuzzy fallback)
+    void searchParcels(const std::string& query) {
+        ParcelSearchIndex::Result result = searchIndex.search(query, 20);
+        if (result.ids.empty()) {
+            output << "No parcels match \"" << query << "\".\n";
+            return;
+        }
+        if (result.fuzzy) {
+            output << "No exact matches. Closest parcels:\n";
+        } else {
+            output << "Parcels matching \"" << query << "\":\n";
+        }
+        for (int id : result.ids) {
+            const ParcelSearchIndex::Entry* entry = searchIndex.find(id);
+            output << "ID: " << id << ", Recipient: " << entry->recipient << ", Address: " << entry->address
+                 << ", Status: " << statusName(entry->status) << "\n";
+        }
+    }
+
+    // Move the truck; every parcel on board moves with it
+    void moveTruck(double x, double y) {
+        if (!(std::fabs(x) <= SpatialGrid::maxCoordinateKm && std::fabs(y) <= SpatialGrid::maxCoordinateKm)) {
+            output << "The truck must stay within " << SpatialGrid::maxCoordinateKm << " km of the depot on each axis.\n";
+            return;
+        }
+        WalRecord record;
+        record.type = WalRecord::MoveTruck;
+        record.x = x;
+        record.y = y;
+        if (!appendLog(record)) {
+            reportLogFailure("truck not moved");
+            return;
+        }
+        truckPosition.x = x;
+        truckPosition.y = y;
+        output << "Truck moved to (" << x << ", " << y << ") km from the depot with " << loadingQueue.size()
+             << " parcel(s) on board.\n";
+        checkpointIfDue();
+    }
+
+    // Parcels within radiusKm of the depot
+    void trackNearDepot(double radiusKm) {
+        printTracked(collectWithin(depotPosition, radiusKm), depotPosition);
+    }
+
+    // Parcels within radiusKm of the truck
+    void trackNearTruck(double radiusKm) {
+        printTracked(collectWithin(truckPosition, radiusKm), truckPosition);
+    }
+
+    // Parcels inside the rectangle with corners (x1, y1) and (x2, y2)
+    void trackInArea(double x1, double y1, double x2, double y2) {
+        Position low, high;
+        low.x = std::min(x1, x2);
+        low.y = std::min(y1, y2);
+        high.x = std::max(x1, x2);
+        high.y = std::max(y1, y2);
+        std::vector<std::pair<int, Position>> found;
+        parcelLocations.forEachInArea(low, high, [&](int id, Position pos) { found.push_back({id, pos}); });
+        if (truckPosition.x >= low.x && truckPosition.x <= high.x && truckPosition.y >= low.y &&
+            truckPosition.y <= high.y) {
+            for (const auto& p : loadingQueue) found.push_back({p.id, truckPosition});
+        }
+        Position centre;
+        centre.x = (low.x + high.x) / 2;
+        centre.y = (low.y + high.y) / 2;
+        printTracked(found, centre);
+    }
+
+    // Load every waiting parcel as one action, so a single undo unloads them all
+    void loadAllParcels() {
+        if (parcelList.empty()) {
+            output << "No parcels left to load.\n";
+            return;
+        }
+        bool started = !history.inGroup();
+        if (started && !beginTransaction()) {
+            reportLogFailure("no parcels loaded");
+            return;
+        }
+        size_t loaded = 0;
+        while (!parcelList.empty() && loadParcels()) {
+            loaded++;
+        }
+        if (started) commitTransaction();
+        output << "Loaded " << loaded << " parcel(s) as one action.\n";
+    }
+
+    // Actions until commitTransaction are undone and redone together.
+    // Returns false if a transaction is already open or the log can't be written.
+    bool beginTransaction() {
+        if (history.inGroup() || !logStep(WalRecord::BeginTransaction)) return false;
+        history.beginGroup();
+        checkpointIfDue();
+        return true;
+    }
+
+    bool commitTransaction() {
+        if (!history.inGroup() || !logStep(WalRecord::CommitTransaction)) return false;
+        history.endGroup();
+        checkpointIfDue();
+        return true;
+    }
+
+    // Undo last action (or the whole transaction it belongs to)
+    void undoLastAction() {
+        if (history.inGroup() && !commitTransaction()) { // An open transaction ends here
+            reportLogFailure("nothing undone");
+            return;
+        }
+        if (!history.canUndo()) {
+            output << "No actions to undo.\n";
+            return;
+        }
+        if (!logStep(WalRecord::Undo)) {
+            reportLogFailure("nothing undone");
+            return;
+        }
+        size_t undone = 0;
+        UndoEntry entry;
+        do {
+            entry = history.undo();
+            undoEntry(entry);
+            undone++;
+        } while (entry.linked() && history.canUndo());
+        if (undone > 1) {
+            output << "Undid " << undone << " actions made as one transaction.\n";
+        }
+        checkpointIfDue();
+    }
+
+    // Redo last undone action (or the whole transaction it belongs to)
+    void redoLastAction() {
+        if (history.inGroup() && !commitTransaction()) {
+            reportLogFailure("nothing redone");
+            return;
+        }
+        if (!history.canRedo()) {
+            output << "No actions to redo.\n";
+            return;
+        }
+        if (!logStep(WalRecord::Redo)) {
+            reportLogFailure("nothing redone");
+            return;
+        }
+        size_t redone = 0;
+        do {
+            redoEntry(history.redo());
+            redone++;
+        } while (history.nextLinked());
+        if (redone > 1) {
+            output << "Redid " << redone << " actions made as one transaction.\n";
+        }
+        checkpointIfDue();
+    }
+
+    // Generate reports
+    void generateReports() {
+
+        output << "Total parcels delivered: " << deliveredParcels.size() << "\n";
+        // Delivered parcels
+        output << "Delivered parcels:\n";
+        deliveredParcels.forEach([&](const DeliveryRecord& parcel) {
+            output << "ID: " << parcel.id << ", Recipient: " << parcel.recipient << "\n";
+        });
+        // Delivery counters are kept up to date on every delivery
+        output << "Deliveries by priority:\n";
+        for (const auto& [priority, count] : deliveredParcels.countsByPriority()) {
+            output << "Priority " << priority << ": " << count << "\n";
+        }
+        output << "Deliveries by hour of day:\n";
+        const auto& perHour = deliveredParcels.countsByHour();
+        for (int hour = 0; hour < 24; hour++) {
+            if (perHour[hour] > 0) {
+                output << (hour < 10 ? "0" : "") << hour << ":00 - " << perHour[hour] << "\n";
+            }
+        }
+        // Parcels pending delivery by priority (set is already in priority order)
+        output << "Parcels pending delivery by priority:\n";
+        for (const auto& [priority, id] : pendingByPriority) {
+            output << "ID: " << id << ", Priority: " << priority << "\n";
+        }
+
+        // Delivery routes used
+        output << "Delivery routes used (order of delivery as entered):\n";
+        if (deliveredParcels.size() > 0) {
+            bool first = true;
+            deliveredParcels.forEach([&](const DeliveryRecord& parcel) {
+                output << (first ? "ID: " : " - ID: ") << parcel.id;
+                first = false;
+            });
+            output << "\n";
+        } else {
+            output << "No delivery routes used.\n";
+        }
+    }
+
+    // Show parcels delivered within the last given number of minutes
+    void viewRecentDeliveries(int minutes) {
+        int64_t now = std::time(nullptr);
+        size_t count = 0;
+        output << "Parcels delivered in the last " << minutes << " minute(s):\n";
+        deliveredParcels.forEachInRange(now - int64_t(minutes) * 60, now, [&](const DeliveryRecord& parcel) {
+            std::time_t when = static_cast<std::time_t>(parcel.deliveredAt);
+            char stamp[20];
+            std::strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", std::localtime(&when));
+            output << "ID: " << parcel.id << ", Recipient: " << parcel.recipient << ", Address: " << parcel.address
+                 << ", Priority: " << parcel.priority << ", Delivered: " << stamp << "\n";
+            count++;
+        });
+        if (count == 0) {
+            output << "No parcels delivered in that time.\n";
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,292 @@
+#ifndef PARCEL_SEARCH_INDEX_H
+#define PARCEL_SEARCH_INDEX_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Lifecycle state of a parcel as seen by the search index
+enum class ParcelStatus { Registered, Loaded, Delivered };
+
+inline const char* statusName(ParcelStatus status) {
+    switch (status) {
+        case ParcelStatus::Registered: return "Registered";
+        case ParcelStatus::Loaded: return "Loaded";
+        case ParcelStatus::Delivered: return "Delivered";
+    }
+    return "Unknown";
+}
+
+// Search index over recipient and address for every parcel, whatever its state.
+// Text is normalized (lower case, punctuation collapsed to single spaces) and split
+// into trigrams; each trigram keeps a sorted posting list of parcel IDs.
+class ParcelSearchIndex {
+public:
+    struct Entry {
+        std::string recipient;
+        std::string address;
+        std::string text; // normalized " recipient \n address ", padded so word edges form trigrams
+        ParcelStatus status;
+    };
+
+    struct Result {
+        std::vector<int> ids; // best matches first
+        bool fuzzy = false;   // true when no exact substring match was found
+    };
+
+    // Lower-case letters and digits, everything else becomes a single space
+    static std::string normalize(const std::string& s) {
+        std::string out;
+        out.reserve(s.size());
+        bool pendingSpace = false;
+        for (unsigned char c : s) {
+            if (std::isalnum(c)) {
+                if (pendingSpace && !out.empty()) out += ' ';
+                pendingSpace = false;
+                out += static_cast<char>(std::tolower(c));
+            } else {
+                pendingSpace = true;
+            }
+        }
+        return out;
+    }
+
+    void add(int id, const std::string& recipient, const std::string& address, ParcelStatus status) {
+        remove(id);
+        Entry entry{recipient, address, ' ' + normalize(recipient) + " \n " + normalize(address) + ' ', status};
+        for (uint32_t gram : trigrams(entry.text)) {
+            std::vector<int>& list = postings[gram];
+            // IDs are handed out in increasing order, so this is almost always an append
+            if (list.empty() || list.back() < id) list.push_back(id);
+            else list.insert(std::lower_bound(list.begin(), list.end(), id), id);
+        }
+        entries.emplace(id, std::move(entry));
+    }
+
+    void remove(int id) {
+        auto it = entries.find(id);
+        if (it == entries.end()) return;
+        for (uint32_t gram : trigrams(it->second.text)) {
+            auto posting = postings.find(gram);
+            if (posting == postings.end()) continue;
+            std::vector<int>& list = posting->second;
+            auto pos = std::lower_bound(list.begin(), list.end(), id);
+            if (pos != list.end() && *pos == id) list.erase(pos);
+            if (list.empty()) postings.erase(posting);
+        }
+        entries.erase(it);
+    }
+
+    void setStatus(int id, ParcelStatus status) {
+        auto it = entries.find(id);
+        if (it != entries.end()) it->second.status = status;
+    }
+
+    const Entry* find(int id) const {
+        auto it = entries.find(id);
+        return it == entries.end() ? nullptr : &it->second;
+    }
+
+    size_t size() const { return entries.size(); }
+
+    // Substring search over recipient and address. Falls back to ranking parcels by
+    // shared trigrams when nothing contains the query (typos, swapped letters).
+    Result search(const std::string& query, size_t limit) const {
+        Result result;
+        std::string needle = normalize(query);
+        if (needle.empty() || limit == 0) return result;
+
+        if (needle.size() < 3) {
+            result.ids = searchShort(needle, limit);
+            return result;
+        }
+
+        std::vector<uint32_t> grams = trigrams(needle);
+        std::vector<const std::vector<int>*> lists;
+        bool allPresent = true;
+        for (uint32_t gram : grams) {
+            auto it = postings.find(gram);
+            if (it == postings.end()) allPresent = false;
+            else lists.push_back(&it->second);
+        }
+
+        if (allPresent) {
+            sortBySize(lists);
+            // Walk the rarest posting list, keep IDs present in all others
+            std::vector<std::vector<int>::const_iterator> cursors;
+            for (const std::vector<int>* list : lists) cursors.push_back(list->begin());
+            for (int id : *lists[0]) {
+                bool inAll = true;
+                for (size_t i = 1; i < lists.size() && inAll; i++) {
+                    cursors[i] = std::lower_bound(cursors[i], lists[i]->end(), id);
+                    inAll = cursors[i] != lists[i]->end() && *cursors[i] == id;
+                }
+                // Candidates share every trigram; confirm the full substring.
+                // string::find runs on the vectorized memchr/memcmp from libc.
+                if (inAll && entries.at(id).text.find(needle) != std::string::npos) {
+                    result.ids.push_back(id);
+                    if (result.ids.size() == limit) break;
+                }
+            }
+            if (!result.ids.empty()) return result;
+        }
+
+        // Rank on the padded query so word starts and ends count towards the overlap
+        std::vector<uint32_t> paddedGrams = trigrams(' ' + needle + ' ');
+        lists.clear();
+        for (uint32_t gram : paddedGrams) {
+            auto it = postings.find(gram);
+            if (it != postings.end()) lists.push_back(&it->second);
+        }
+        result.fuzzy = true;
+        result.ids = rankByOverlap(lists, paddedGrams.size(), limit);
+        return result;
+    }
+
+private:
+    std::unordered_map<int, Entry> entries;
+    std::unordered_map<uint32_t, std::vector<int>> postings;
+
+    // Unique trigrams of normalized text, skipping ones that span the field separator
+    static std::vector<uint32_t> trigrams(const std::string& text) {
+        std::vector<uint32_t> grams;
+        if (text.size() < 3) return grams;
+        grams.reserve(text.size() - 2);
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            if (text[i] == '\n' || text[i + 1] == '\n' || text[i + 2] == '\n') continue;
+            grams.push_back(static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16 |
+                            static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8 |
+                            static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2])));
+        }
+        std::sort(grams.begin(), grams.end());
+        grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+    static uint32_t gramOf(char a, char b, char c) {
+        return static_cast<uint32_t>(static_cast<unsigned char>(a)) << 16 |
+               static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8 |
+               static_cast<uint32_t>(static_cast<unsigned char>(c));
+    }
+
+    // A normalized needle of one or two characters has no spaces. Text is padded
+    // and '\n' always has spaces on both sides, so every character sits in the
+    // middle of a trigram and every pair starts one. Parcels containing the
+    // needle are therefore the union of the trigram lists "?x?" or "xy?".
+    std::vector<int> searchShort(const std::string& needle, size_t limit) const {
+        static const std::string neighbours = " abcdefghijklmnopqrstuvwxyz0123456789";
+        std::vector<const std::vector<int>*> lists;
+        for (char a : neighbours) {
+            for (char b : neighbours) {
+                uint32_t gram = needle.size() == 1 ? gramOf(a, needle[0], b) : gramOf(needle[0], needle[1], b);
+                auto it = postings.find(gram);
+                if (it != postings.end()) lists.push_back(&it->second);
+            }
+            if (needle.size() == 2) break;
+        }
+        return smallestInUnion(lists, limit);
+    }
+
+    // The limit smallest IDs found in any of the sorted lists
+    static std::vector<int> smallestInUnion(const std::vector<const std::vector<int>*>& lists, size_t limit) {
+        using Head = std::pair<int, size_t>; // (id, list)
+        std::vector<Head> heap;
+        std::vector<size_t> pos(lists.size(), 0);
+        for (size_t i = 0; i < lists.size(); i++) heap.push_back({lists[i]->front(), i});
+        std::make_heap(heap.begin(), heap.end(), std::greater<Head>());
+        std::vector<int> ids;
+        while (!heap.empty() && ids.size() < limit) {
+            std::pop_heap(heap.begin(), heap.end(), std::greater<Head>());
+            auto [id, list] = heap.back();
+            heap.pop_back();
+            if (ids.empty() || ids.back() != id) ids.push_back(id);
+            if (++pos[list] < lists[list]->size()) {
+                heap.push_back({(*lists[list])[pos[list]], list});
+                std::push_heap(heap.begin(), heap.end(), std::greater<Head>());
+            }
+        }
+        return ids;
+    }
+
+    // First position at or after from whose ID is not below id, galloping
+    // ahead so skipping a long stretch of a large list costs O(log distance)
+    static size_t gallop(const std::vector<int>& list, size_t from, int id) {
+        size_t step = 1, low = from, high = from;
+        while (high < list.size() && list[high] < id) {
+            low = high + 1;
+            high += step;
+            step *= 2;
+        }
+        high = std::min(high, list.size());
+        return static_cast<size_t>(std::lower_bound(list.begin() + low, list.begin() + high, id) - list.begin());
+    }
+
+    static void sortBySize(std::vector<const std::vector<int>*>& lists) {
+        std::sort(lists.begin(), lists.end(), [](const std::vector<int>* a, const std::vector<int>* b) {
+            return a->size() < b->size();
+        });
+    }
+
+    // Parcels sharing at least 40% of the query trigrams, most shared first (ties by ID).
+    // IDs are visited in increasing order. Once limit parcels are held, a later ID
+    // must share more trigrams than the weakest of them, which raises the
+    // threshold. An ID meeting threshold t must be in one of the rarest
+    // (lists - t + 1) lists, so only those are walked; the rest are probed by
+    // galloping ahead. Large lists stop being walked as soon as results fill up.
+    static std::vector<int> rankByOverlap(std::vector<const std::vector<int>*> lists,
+                                          size_t totalGrams, size_t limit) {
+        size_t threshold = std::max<size_t>(1, (totalGrams * 2 + 4) / 5);
+        if (lists.size() < threshold) return {};
+        sortBySize(lists);
+
+        // held is a heap of (shared trigrams, id) with the weakest result on top
+        auto better = [](const std::pair<size_t, int>& a, const std::pair<size_t, int>& b) {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        };
+        std::vector<std::pair<size_t, int>> held;
+        std::vector<size_t> pos(lists.size(), 0);
+        while (threshold <= lists.size()) {
+            size_t sources = lists.size() - threshold + 1;
+            int id = 0;
+            bool any = false;
+            for (size_t i = 0; i < sources; i++) {
+                if (pos[i] < lists[i]->size() && (!any || (*lists[i])[pos[i]] < id)) {
+                    id = (*lists[i])[pos[i]];
+                    any = true;
+                }
+            }
+            if (!any) break;
+
+            size_t count = 0;
+            for (size_t i = 0; i < lists.size(); i++) {
+                if (i >= sources && count + (lists.size() - i) < threshold) break; // Can't reach it any more
+                pos[i] = gallop(*lists[i], pos[i], id);
+                if (pos[i] < lists[i]->size() && (*lists[i])[pos[i]] == id) {
+                    count++;
+                    pos[i]++;
+                }
+            }
+            if (count < threshold) continue;
+
+            held.push_back({count, id});
+            std::push_heap(held.begin(), held.end(), better);
+            if (held.size() > limit) {
+                std::pop_heap(held.begin(), held.end(), better);
+                held.pop_back();
+            }
+            // Later IDs are larger, so only a strictly higher count can displace the weakest
+            if (held.size() == limit) threshold = std::max(threshold, held.front().first + 1);
+        }
+
+        std::sort(held.begin(), held.end(), better);
+        std::vector<int> ids;
+        for (const auto& entry : held) ids.push_back(entry.second);
+        return ids;
+    }
+};
+
+#endif
@@ -0,0 +1,150 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Location in km east (x) and north (y) of the depot
+struct Position {
+    double x = 0;
+    double y = 0;
+};
+
+inline double distanceKm(Position a, Position b) {
+    return std::hypot(a.x - b.x, a.y - b.y);
+}
+
+// Uniform grid of square cells over the plane. Each item remembers its cell and
+// slot, so moving an item is O(1): updated in place, or swap-removed from the
+// old cell and appended to the new one. Queries only visit cells that overlap
+// the query area.
+class SpatialGrid {
+public:
+    // Positions further out than this (about half the Earth's circumference) are
+    // rejected by the system before they reach the grid
+    static constexpr double maxCoordinateKm = 20000;
+
+    explicit SpatialGrid(double cellSizeKm = 1.0) : cellSize(cellSizeKm > 0 ? cellSizeKm : 1.0) {}
+
+    void upsert(int id, Position pos) {
+        int64_t cell = cellOf(pos);
+        auto it = where.find(id);
+        if (it != where.end()) {
+            if (it->second.cell == cell) {
+                cells[cell][it->second.slot].pos = pos;
+                return;
+            }
+            detach(it->second);
+            where.erase(it);
+        }
+        std::vector<Item>& items = cells[cell];
+        where[id] = {cell, static_cast<uint32_t>(items.size())};
+        items.push_back({id, pos});
+    }
+
+    void remove(int id) {
+        auto it = where.find(id);
+        if (it == where.end()) return;
+        detach(it->second);
+        where.erase(it);
+    }
+
+    bool position(int id, Position& out) const {
+        auto it = where.find(id);
+        if (it == where.end()) return false;
+        out = cells.at(it->second.cell)[it->second.slot].pos;
+        return true;
+    }
+
+    size_t size() const { return where.size(); }
+
+    // visit(id, position) for every item within radiusKm of center
+    template <typename Visitor>
+    void forEachWithin(Position center, double radiusKm, Visitor visit) const {
+        double r2 = radiusKm * radiusKm;
+        forEachCandidate({center.x - radiusKm, center.y - radiusKm}, {center.x + radiusKm, center.y + radiusKm},
+                         [&](const Item& item) {
+                             double dx = item.pos.x - center.x, dy = item.pos.y - center.y;
+                             if (dx * dx + dy * dy <= r2) visit(item.id, item.pos);
+                         });
+    }
+
+    // visit(id, position) for every item inside the rectangle [low, high]
+    template <typename Visitor>
+    void forEachInArea(Position low, Position high, Visitor visit) const {
+        forEachCandidate(low, high, [&](const Item& item) {
+            if (item.pos.x >= low.x && item.pos.x <= high.x && item.pos.y >= low.y && item.pos.y <= high.y) {
+                visit(item.id, item.pos);
+            }
+        });
+    }
+
+private:
+    struct Item {
+        int id;
+        Position pos;
+    };
+
+    struct Slot {
+        int64_t cell;
+        uint32_t slot;
+    };
+
+    double cellSize;
+    std::unordered_map<int64_t, std::vector<Item>> cells;
+    std::unordered_map<int, Slot> where;
+
+    // Cell index along one axis. Clamped so any double (even NaN) gives a valid
+    // int32_t; items past the edge share the edge cell and are still filtered
+    // by their exact position.
+    int32_t coord(double v) const {
+        const double limit = 1e9;
+        double c = std::floor(v / cellSize);
+        if (!(c > -limit)) return static_cast<int32_t>(-limit);
+        if (c > limit) return static_cast<int32_t>(limit);
+        return static_cast<int32_t>(c);
+    }
+
+    static int64_t key(int32_t cx, int32_t cy) {
+        return static_cast<int64_t>(static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32 | static_cast<uint32_t>(cy));
+    }
+
+    int64_t cellOf(Position pos) const { return key(coord(pos.x), coord(pos.y)); }
+
+    void detach(const Slot& slot) {
+        auto cell = cells.find(slot.cell);
+        std::vector<Item>& items = cell->second;
+        if (slot.slot + 1 != items.size()) {
+            items[slot.slot] = items.back();
+            where[items[slot.slot].id].slot = slot.slot;
+        }
+        items.pop_back();
+        if (items.empty()) cells.erase(cell);
+    }
+
+    template <typename Visitor>
+    void forEachCandidate(Position low, Position high, Visitor visit) const {
+        if (!(low.x <= high.x && low.y <= high.y)) return;
+        double spanX = std::floor(high.x / cellSize) - std::floor(low.x / cellSize) + 1;
+        double spanY = std::floor(high.y / cellSize) - std::floor(low.y / cellSize) + 1;
+        if (spanX * spanY > static_cast<double>(cells.size())) {
+            // Area covers more cells than are occupied: walk the occupied ones
+            for (const auto& [cell, items] : cells) {
+                for (const Item& item : items) visit(item);
+            }
+            return;
+        }
+        int32_t x0 = coord(low.x), x1 = coord(high.x), y0 = coord(low.y), y1 = coord(high.y);
+        for (int32_t cx = x0; cx <= x1; cx++) {
+            for (int32_t cy = y0; cy <= y1; cy++) {
+                auto it = cells.find(key(cx, cy));
+                if (it == cells.end()) continue;
+                for (const Item& item : it->second) visit(item);
+            }
+        }
+    }
+};
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef UNDO_HISTORY_H
+#define UNDO_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One undoable action: what was done to which parcel. The parcel's details
+// live in the system's own structures, so an entry is only 8 bytes.
+struct UndoEntry {
+    enum Op : uint8_t { Register = 1, Load };
+    enum Flags : uint8_t { LinkedToPrevious = 1 }; // Undone and redone together with the entry before it
+
+    Op op = Register;
+    uint8_t flags = 0;
+    int32_t parcelId = 0;
+
+    bool linked() const { return flags & LinkedToPrevious; }
+};
+
+static_assert(sizeof(UndoEntry) == 8, "undo entries are meant to stay 8 bytes");
+
+// Fixed-capacity ring of undo entries. Positions only ever grow:
+// [begin, cursor) can be undone, [cursor, end) can be redone. When the ring
+// is full the oldest action (a whole transaction, if it was one) is dropped,
+// so memory stays the same however long the system runs.
+class UndoHistory {
+public:
+    explicit UndoHistory(size_t capacity = 10000) : ring(capacity > 0 ? capacity : 1) {}
+
+    // Record a new action. Entries that could still have been redone are
+    // passed to discarded(entry) and dropped.
+    template <typename OnDiscard>
+    void record(UndoEntry::Op op, int parcelId, OnDiscard discarded) {
+        for (uint64_t pos = cursor; pos < end; pos++) discarded(at(pos));
+        end = cursor;
+        if (end - begin == ring.size()) evictOldest();
+
+        UndoEntry entry;
+        entry.op = op;
+        entry.parcelId = parcelId;
+        if (grouping && linkNext && end > begin) entry.flags = UndoEntry::LinkedToPrevious;
+        at(end++) = entry;
+        cursor = end;
+        linkNext = grouping;
+    }
+
+    // Actions recorded between beginGroup and endGroup are undone as one
+    bool beginGroup() {
+        if (grouping) return false;
+        grouping = true;
+        linkNext = false;
+        return true;
+    }
+
+    bool endGroup() {
+        if (!grouping) return false;
+        grouping = false;
+        linkNext = false;
+        return true;
+    }
+
+    bool inGroup() const { return grouping; }
+    bool linksNext() const { return linkNext; }
+    bool canUndo() const { return cursor > begin; }
+    bool canRedo() const { return cursor < end; }
+
+    // Step back over the newest undoable entry; keep going while it is linked()
+    UndoEntry undo() { return at(--cursor); }
+
+    // Step forward over the oldest redoable entry; keep going while nextLinked()
+    UndoEntry redo() { return at(cursor++); }
+    bool nextLinked() const { return canRedo() && at(cursor).linked(); }
+
+    size_t capacity() const { return ring.size(); }
+    size_t size() const { return static_cast<size_t>(end - begin); }
+    size_t undoCount() const { return static_cast<size_t>(cursor - begin); }
+
+    // i-th entry from the oldest, for snapshots
+    const UndoEntry& entry(size_t i) const { return at(begin + i); }
+
+    // Replace the contents with entries (oldest first), the first undoCount of them undoable
+    void assign(const std::vector<UndoEntry>& entries, size_t undoCount, bool inGroup, bool linkNextEntry) {
+        begin = cursor = end = 0;
+        for (size_t i = 0; i < entries.size(); i++) {
+            if (end - begin == ring.size()) evictOldest();
+            at(end++) = entries[i];
+            if (i < undoCount) cursor = end;
+        }
+        if (cursor < begin) cursor = begin;
+        grouping = inGroup;
+        linkNext = linkNextEntry;
+    }
+
+private:
+    std::vector<UndoEntry> ring;
+    uint64_t begin = 0;
+    uint64_t cursor = 0;
+    uint64_t end = 0;
+    bool grouping = false; // Inside a transaction
+    bool linkNext = false; // The next entry joins the transaction's earlier ones
+
+    UndoEntry& at(uint64_t pos) { return ring[pos % ring.size()]; }
+    const UndoEntry& at(uint64_t pos) const { return ring[pos % ring.size()]; }
+
+    // Drop the oldest action with everything linked to it. A transaction still
+    // being recorded that fills the whole ring loses only its oldest entry, so
+    // its newest part stays undoable.
+    void evictOldest() {
+        uint64_t next = begin + 1;
+        while (next < end && at(next).linked()) next++;
+        if (next == end && grouping && linkNext) next = begin + 1;
+        begin = next;
+        if (begin < end) at(begin).flags &= ~UndoEntry::LinkedToPrevious;
+        if (cursor < begin) cursor = begin;
+    }
+};
+
+#endif
@@ -0,0 +1,290 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "parcelDeliverySystem.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Crash test for the write-ahead log. Each round forks a child that recovers
+// the system from disk and keeps applying random actions, acknowledging each
+// one through a pipe once it returns. The parent kills the child with SIGKILL
+// at a random moment, recovers the files itself and checks the result against
+// a reference system that applied the same actions: every acknowledged action
+// must be there, and at most the one in flight on top. The reference logs too
+// (without ever syncing), so matching log sequence numbers tell apart actions
+// that leave no visible trace, such as an undo that kept a registration.
+
+// One action of the workload. A Load All cut short by the crash is kept with
+// the number of loads that made it to disk.
+struct Step {
+    enum Kind { Register, Load, Deliver, Undo, Redo, MoveTruck, LoadAll };
+
+    Kind kind = Register;
+    string recipient;
+    string address;
+    int priority = 0;
+    double x = 0, y = 0;
+    int loads = -1; // LoadAll only: -1 loads everything
+};
+
+// The n-th action of the workload, the same in every process
+Step makeStep(unsigned seed, uint64_t n) {
+    static const char* names[] = {"Alice Smith", "Bob Jones", "Carol White", "Dan Brown", "Eve Black", "Frank Green"};
+    static const char* streets[] = {"Oak Avenue", "Elm Street", "High Road", "Mill Lane"};
+    mt19937_64 rng(seed * 1000003ull + n);
+    Step step;
+    int roll = static_cast<int>(rng() % 100);
+    if (roll < 40) {
+        step.kind = Step::Register;
+        step.recipient = string(names[rng() % 6]) + " " + to_string(rng() % 50);
+        step.address = to_string(1 + rng() % 200) + " " + streets[rng() % 4];
+        step.priority = 1 + static_cast<int>(rng() % 5);
+    } else if (roll < 55) {
+        step.kind = Step::Load;
+    } else if (roll < 75) {
+        step.kind = Step::Deliver;
+    } else if (roll < 83) {
+        step.kind = Step::Undo;
+    } else if (roll < 88) {
+        step.kind = Step::Redo;
+    } else if (roll < 95) {
+        step.kind = Step::MoveTruck;
+        step.x = static_cast<int>(rng() % 1000) / 10.0 - 50;
+        step.y = static_cast<int>(rng() % 1000) / 10.0 - 50;
+    } else {
+        step.kind = Step::LoadAll;
+    }
+    return step;
+}
+
+void applyStep(ParcelDeliverySystem& system, const Step& step) {
+    switch (step.kind) {
+        case Step::Register: system.registerParcel(step.recipient, step.address, step.priority); break;
+        case Step::Load: system.loadParcels(); break;
+        case Step::Deliver: system.deliverParcel(); break;
+        case Step::Undo: system.undoLastAction(); break;
+        case Step::Redo: system.redoLastAction(); break;
+        case Step::MoveTruck: system.moveTruck(step.x, step.y); break;
+        case Step::LoadAll:
+            if (step.loads < 0) {
+                system.loadAllParcels();
+            } else if (system.beginTransaction()) {
+                for (int i = 0; i < step.loads; i++) system.loadParcels();
+                system.commitTransaction();
+            }
+            break;
+    }
+}
+
+// Everything the system shows about its state, minus delivery times: those
+// come from the clock and differ between the crashed run and the reference
+string stateOf(ParcelDeliverySystem& system, ostringstream& out, uint64_t lastId) {
+    out.str("");
+    system.generateReports();
+    for (uint64_t id = 1; id <= lastId; id++) system.searchParcelById(static_cast<int>(id));
+    system.searchParcels("oak");
+    system.trackNearDepot(1e6);
+    system.trackNearTruck(1e6);
+    istringstream lines(out.str());
+    string line, state;
+    while (getline(lines, line)) {
+        bool hourLine = line.size() > 5 && line.compare(2, 6, ":00 - ") == 0;
+        if (!hourLine) state += line + "\n";
+    }
+    return state;
+}
+
+struct Paths {
+    string log, snapshot, spill;
+};
+
+// Same printed state and the same number of logged records
+bool sameState(ParcelDeliverySystem& system, ostringstream& out, uint64_t lastId, uint64_t lsn,
+               const string& state) {
+    return system.lastLogSequence() == lsn && stateOf(system, out, lastId) == state;
+}
+
+bool openSystem(ParcelDeliverySystem& system, const Paths& paths, size_t group) {
+    return system.setHistorySpillFile(paths.spill, 7) && // Small segments so snapshots refer to many
+           system.enablePersistence(paths.log, paths.snapshot, group, 2048);
+}
+
+#ifdef _WIN32
+
+int main() {
+    cout << "walCrashTest needs fork() and kill(); run it on Linux or macOS.\n";
+    return 0;
+}
+
+#else
+
+// Run actions from `next` on until killed, writing the number of durable
+// actions to ackFd after each one (after each flushLog with group commit)
+[[noreturn]] void runChild(const Paths& paths, unsigned seed, uint64_t next, size_t group, int ackFd) {
+    ostream silent(nullptr);
+    ParcelDeliverySystem system(silent);
+    if (!openSystem(system, paths, group)) _exit(3);
+    for (uint64_t done = 1;; done++, next++) {
+        applyStep(system, makeStep(seed, next));
+        if (done % group != 0) continue;
+        if (!system.flushLog()) _exit(4);
+        if (write(ackFd, &done, sizeof(done)) != sizeof(done)) _exit(5);
+    }
+}
+
+void usage() {
+    cout << "Usage: walCrashTest [options]\n"
+         << "  --rounds N     crashes to survive (default 50)\n"
+         << "  --delay MS     kill the child within this many milliseconds (default 30)\n"
+         << "  --group N      records per commit; acknowledge after every flushLog (default 1)\n"
+         << "  --dir PATH     where the log, snapshot and spill file go (default walCrashTest.data)\n"
+         << "  --seed N       random seed (default 1)\n";
+}
+
+int main(int argc, char** argv) {
+    size_t rounds = 50, group = 1;
+    double delayMs = 30;
+    string dir = "walCrashTest.data";
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--rounds" && hasValue) rounds = stoull(argv[++i]);
+        else if (arg == "--delay" && hasValue) delayMs = stod(argv[++i]);
+        else if (arg == "--group" && hasValue) group = max<size_t>(1, stoull(argv[++i]));
+        else if (arg == "--dir" && hasValue) dir = argv[++i];
+        else if (arg == "--seed" && hasValue) seed = static_cast<unsigned>(stoul(argv[++i]));
+        else {
+            usage();
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    filesystem::remove_all(dir);
+    filesystem::create_directories(dir);
+    Paths paths{dir + "/parcels.wal", dir + "/parcels.snapshot", dir + "/delivered_history.bin"};
+    mt19937 rng(seed);
+    uniform_real_distribution<double> delay(0.2, max(0.2, delayMs));
+    vector<Step> script; // Every action the files are known to hold, oldest first
+    uint64_t acknowledgedTotal = 0;
+
+    for (size_t round = 1; round <= rounds; round++) {
+        int fds[2];
+        if (pipe(fds) != 0) {
+            perror("pipe");
+            return 1;
+        }
+        cout.flush();
+        pid_t child = fork();
+        if (child < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (child == 0) {
+            close(fds[0]);
+            runChild(paths, seed, script.size(), group, fds[1]);
+        }
+        close(fds[1]);
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+        // Keep draining acknowledgements so the child never blocks on the pipe
+        uint64_t acknowledged = 0, value = 0;
+        size_t partial = 0;
+        auto drain = [&] {
+            ssize_t got;
+            while ((got = read(fds[0], reinterpret_cast<char*>(&value) + partial, sizeof(value) - partial)) > 0) {
+                partial += static_cast<size_t>(got);
+                if (partial == sizeof(value)) {
+                    acknowledged = value;
+                    partial = 0;
+                }
+            }
+        };
+        auto deadline = chrono::steady_clock::now() + chrono::duration<double, milli>(delay(rng));
+        while (chrono::steady_clock::now() < deadline) {
+            drain();
+            usleep(100);
+        }
+        kill(child, SIGKILL);
+        int status = 0;
+        waitpid(child, &status, 0);
+        drain();
+        close(fds[0]);
+        if (!WIFSIGNALED(status)) {
+            cout << "Round " << round << ": child exited with status " << WEXITSTATUS(status)
+                 << " before it was killed (could not open or write the files)\n";
+            return 1;
+        }
+
+        // Recover what the crashed child left behind
+        ostringstream recoveredOut;
+        ParcelDeliverySystem recovered(recoveredOut);
+        if (!openSystem(recovered, paths, group)) {
+            cout << "Round " << round << ": recovery failed after " << acknowledged << " acknowledged action(s)\n";
+            return 1;
+        }
+        uint64_t next = script.size();
+        uint64_t lastId = next + acknowledged + group + 1;
+        string actual = stateOf(recovered, recoveredOut, lastId);
+        uint64_t lsn = recovered.lastLogSequence();
+
+        // Walk a reference system through the acknowledged actions, then through
+        // the ones that may have reached the disk before the kill
+        filesystem::remove(dir + "/reference.wal");
+        ostringstream referenceOut;
+        ParcelDeliverySystem reference(referenceOut);
+        reference.enablePersistence(dir + "/reference.wal", dir + "/reference.snapshot", SIZE_MAX, UINT64_MAX);
+        for (const Step& step : script) applyStep(reference, step);
+        for (uint64_t i = 0; i < acknowledged; i++) {
+            script.push_back(makeStep(seed, next + i));
+            applyStep(reference, script.back());
+        }
+        bool matched = sameState(reference, referenceOut, lastId, lsn, actual);
+        for (size_t extra = 0; !matched && extra < group; extra++) {
+            Step step = makeStep(seed, script.size());
+            if (step.kind == Step::LoadAll && reference.waitingCount() > 0) {
+                // Its loads are logged one by one, so any number of them may have survived
+                step.loads = 0;
+                if (!reference.beginTransaction()) break;
+                // Recovery closes the cut-off transaction, so count its commit record too
+                while (!(matched = stateOf(reference, referenceOut, lastId) == actual &&
+                                   reference.lastLogSequence() + 1 == lsn) &&
+                       reference.loadParcels()) {
+                    step.loads++;
+                }
+                reference.commitTransaction();
+            } else {
+                applyStep(reference, step);
+                matched = sameState(reference, referenceOut, lastId, lsn, actual);
+            }
+            script.push_back(step);
+        }
+        if (!matched) {
+            cout << "Round " << round << ": recovered state does not match " << acknowledged
+                 << " acknowledged action(s) or any action in flight after them\n";
+            return 1;
+        }
+        acknowledgedTotal += acknowledged;
+        cout << "Round " << round << ": killed after " << acknowledged << " acknowledged action(s), "
+             << script.size() << " recovered in total\n";
+    }
+
+    cout << rounds << " crash(es), " << acknowledgedTotal << " acknowledged action(s), none lost.\n";
+    filesystem::remove_all(dir);
+    return 0;
+}
+
+#endif
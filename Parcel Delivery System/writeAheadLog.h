@@ -0,0 +1,330 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// Flush a stdio file all the way to disk
+inline bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Make a rename inside the directory of path durable (no-op on Windows)
+inline void syncDirectoryOf(const std::string& path) {
+#ifndef _WIN32
+    std::string dir = std::filesystem::path(path).parent_path().string();
+    int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)path;
+#endif
+}
+
+inline uint32_t crc32(const char* data, size_t size) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Little-endian encoding helpers shared by log records and snapshots
+class ByteWriter {
+public:
+    std::string data;
+
+    void u8(uint8_t v) { data += static_cast<char>(v); }
+    void u32(uint32_t v) { for (int i = 0; i < 4; i++) data += static_cast<char>(v >> (8 * i)); }
+    void u64(uint64_t v) { for (int i = 0; i < 8; i++) data += static_cast<char>(v >> (8 * i)); }
+    void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+    void i64(int64_t v) { u64(static_cast<uint64_t>(v)); }
+    void f64(double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        u64(bits);
+    }
+    void str(const std::string& s) { u32(static_cast<uint32_t>(s.size())); data += s; }
+};
+
+class ByteReader {
+public:
+    ByteReader(const std::string& data) : data(data) {}
+
+    bool ok() const { return good; }
+    bool atEnd() const { return pos == data.size(); }
+
+    uint8_t u8() { return need(1) ? static_cast<uint8_t>(data[pos++]) : 0; }
+    uint32_t u32() {
+        if (!need(4)) return 0;
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        return v;
+    }
+    uint64_t u64() {
+        if (!need(8)) return 0;
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(static_cast<unsigned char>(data[pos++])) << (8 * i);
+        return v;
+    }
+    int32_t i32() { return static_cast<int32_t>(u32()); }
+    int64_t i64() { return static_cast<int64_t>(u64()); }
+    double f64() {
+        uint64_t bits = u64();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    std::string str() {
+        uint32_t size = u32();
+        if (!need(size)) return {};
+        std::string s = data.substr(pos, size);
+        pos += size;
+        return s;
+    }
+
+private:
+    const std::string& data;
+    size_t pos = 0;
+    bool good = true;
+
+    bool need(size_t n) {
+        if (!good || data.size() - pos < n) good = false;
+        return good;
+    }
+};
+
+// Write data with a checksum to path atomically: temp file, fsync, rename, fsync directory
+inline bool writeChecksummedFile(const std::string& path, const std::string& data) {
+    std::string temp = path + ".tmp";
+    std::FILE* file = std::fopen(temp.c_str(), "wb");
+    if (!file) return false;
+    ByteWriter header;
+    header.u64(data.size());
+    header.u32(crc32(data.data(), data.size()));
+    bool ok = std::fwrite(header.data.data(), 1, header.data.size(), file) == header.data.size() &&
+              std::fwrite(data.data(), 1, data.size(), file) == data.size() && syncFile(file);
+    std::fclose(file);
+    if (!ok) return false;
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+    if (error) return false;
+    syncDirectoryOf(path);
+    return true;
+}
+
+// Read a file written by writeChecksummedFile. Returns false if missing or corrupt.
+inline bool readChecksummedFile(const std::string& path, std::string& data) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return false;
+    std::string header(12, '\0');
+    bool ok = std::fread(&header[0], 1, header.size(), file) == header.size();
+    if (ok) {
+        ByteReader reader(header);
+        uint64_t size = reader.u64();
+        uint32_t crc = reader.u32();
+        std::error_code error;
+        uint64_t fileSize = std::filesystem::file_size(path, error);
+        if (error || size != fileSize - header.size()) {
+            std::fclose(file);
+            return false;
+        }
+        data.assign(static_cast<size_t>(size), '\0');
+        ok = std::fread(&data[0], 1, data.size(), file) == data.size() && crc32(data.data(), data.size()) == crc;
+    }
+    std::fclose(file);
+    return ok;
+}
+
+// One logged parcel action
+struct WalRecord {
+    enum Type : uint8_t { Register = 1, Load, Deliver, Undo, Redo, MoveTruck, BeginTransaction, CommitTransaction };
+
+    uint64_t lsn = 0; // log sequence number, increases by one per record
+    Type type = Register;
+    int id = 0;
+    int priority = 0;
+    int64_t time = 0;
+    std::string recipient;
+    std::string address;
+    double x = 0; // truck position for MoveTruck
+    double y = 0;
+};
+
+// Append-only log of parcel actions. Each record is framed as
+// [payload length][crc32 of payload][payload], so a torn or corrupt tail is
+// detected on recovery and cut off. Records are buffered and written with a
+// single fsync once groupSize records are pending (group commit); commit()
+// forces the flush. An action is durable only after the commit covering it.
+// A failed write is cut back off the file and its records stay pending, so a
+// later commit retries them.
+class WriteAheadLog {
+public:
+    ~WriteAheadLog() { close(); }
+
+    // Open (or create) the log and return every intact record in it
+    bool open(const std::string& logPath, std::vector<WalRecord>& records, size_t recordsPerCommit = 1) {
+        close();
+        path = logPath;
+        groupSize = recordsPerCommit == 0 ? 1 : recordsPerCommit;
+        uint64_t validBytes = readAll(records);
+
+        // Drop a torn tail left by a crash so new records follow the last good one
+        std::error_code error;
+        if (std::filesystem::exists(path, error) && std::filesystem::file_size(path, error) != validBytes) {
+            std::filesystem::resize_file(path, validBytes, error);
+            if (error) return false;
+        }
+        durableBytes = validBytes;
+        file = std::fopen(path.c_str(), "ab");
+        return file != nullptr;
+    }
+
+    bool isOpen() const { return file != nullptr; }
+
+    // Returns false if the record could not be written; it is then dropped
+    // and records appended before it stay pending
+    bool append(const WalRecord& record) {
+        if (!file) return false;
+        ByteWriter payload;
+        payload.u64(record.lsn);
+        payload.u8(record.type);
+        payload.i32(record.id);
+        payload.i32(record.priority);
+        payload.i64(record.time);
+        payload.str(record.recipient);
+        payload.str(record.address);
+        payload.f64(record.x);
+        payload.f64(record.y);
+
+        ByteWriter frame;
+        frame.u32(static_cast<uint32_t>(payload.data.size()));
+        frame.u32(crc32(payload.data.data(), payload.data.size()));
+        size_t mark = pending.size();
+        pending += frame.data;
+        pending += payload.data;
+        pendingRecords++;
+        if (pendingRecords >= groupSize && !commit()) {
+            pending.resize(mark);
+            pendingRecords--;
+            return false;
+        }
+        return true;
+    }
+
+    // Write and fsync everything appended so far. On failure nothing counts as
+    // written: the file is cut back to its last durable size and the records
+    // stay pending.
+    bool commit() {
+        if (!file) return false;
+        if (pending.empty()) return true;
+        if (std::fwrite(pending.data(), 1, pending.size(), file) != pending.size() || !syncFile(file)) {
+            discardUnsynced();
+            return false;
+        }
+        durableBytes += pending.size();
+        pending.clear();
+        pendingRecords = 0;
+        commits++;
+        return true;
+    }
+
+    // Empty the log once a snapshot covers all of its records
+    bool reset() {
+        if (!commit()) return false;
+        std::fclose(file);
+        file = std::fopen(path.c_str(), "wb");
+        durableBytes = 0;
+        return file != nullptr && syncFile(file);
+    }
+
+    void close() {
+        if (file) {
+            commit();
+            std::fclose(file);
+            file = nullptr;
+        }
+    }
+
+    size_t commitCount() const { return commits; }
+
+    // Bytes in the log, including records not yet committed
+    uint64_t size() const { return durableBytes + pending.size(); }
+
+private:
+    std::string path;
+    std::FILE* file = nullptr;
+    std::string pending;
+    size_t pendingRecords = 0;
+    size_t groupSize = 1;
+    size_t commits = 0;
+    uint64_t durableBytes = 0; // Length of the file up to the last successful commit
+
+    void discardUnsynced() {
+        std::fclose(file);
+        std::error_code error;
+        std::filesystem::resize_file(path, durableBytes, error);
+        file = error ? nullptr : std::fopen(path.c_str(), "ab");
+    }
+
+    uint64_t readAll(std::vector<WalRecord>& records) {
+        std::FILE* in = std::fopen(path.c_str(), "rb");
+        if (!in) return 0;
+        uint64_t validBytes = 0;
+        std::string header(8, '\0');
+        std::string payload;
+        while (std::fread(&header[0], 1, header.size(), in) == header.size()) {
+            ByteReader frame(header);
+            uint32_t size = frame.u32();
+            uint32_t crc = frame.u32();
+            if (size > (64u << 20)) break; // larger than any record we write: corrupt length
+            payload.assign(size, '\0');
+            if (std::fread(&payload[0], 1, size, in) != size || crc32(payload.data(), size) != crc) break;
+
+            ByteReader reader(payload);
+            WalRecord record;
+            record.lsn = reader.u64();
+            record.type = static_cast<WalRecord::Type>(reader.u8());
+            record.id = reader.i32();
+            record.priority = reader.i32();
+            record.time = reader.i64();
+            record.recipient = reader.str();
+            record.address = reader.str();
+            record.x = reader.f64();
+            record.y = reader.f64();
+            if (!reader.ok()) break;
+            records.push_back(record);
+            validBytes += header.size() + size;
+        }
+        std::fclose(in);
+        return validBytes;
+    }
+};
+
+#endif
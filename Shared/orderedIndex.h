@@ -0,0 +1,421 @@
+#ifndef ORDERED_INDEX_H
+#define ORDERED_INDEX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Node layout of an OrderedIndex: how many keys fit in one node. Wider nodes
+// mean a shallower tree and fewer cache misses per lookup, but more keys to
+// move on every insert and erase.
+template <std::size_t MaxKeys>
+struct BTreeLayout {
+    static_assert(MaxKeys >= 4, "a node needs room for at least 4 keys");
+    static constexpr std::size_t maxKeys = MaxKeys;
+};
+
+// Roughly 256 bytes of keys per node: 64 ints, 32 64-bit keys, 16 strings
+template <typename Key>
+using DefaultLayout = BTreeLayout<(sizeof(Key) <= 4 ? 64 : sizeof(Key) <= 8 ? 32 : 16)>;
+
+// Position of the first of keys[0, count) that is not less than key.
+// The general version is a binary search with the index's comparator.
+template <typename Key, typename Compare, typename = void>
+struct KeySearch {
+    static std::size_t lowerBound(const Key* keys, std::size_t count, const Key& key, const Compare& less) {
+        return static_cast<std::size_t>(std::lower_bound(keys, keys + count, key, less) - keys);
+    }
+};
+
+// Integer keys in their natural order: count the smaller keys in one pass.
+// There are no branches to mispredict and no early exit, so the compiler can
+// turn the loop into SIMD compares.
+template <typename Key>
+struct KeySearch<Key, std::less<Key>, std::enable_if_t<std::is_integral_v<Key>>> {
+    static std::size_t lowerBound(const Key* keys, std::size_t count, const Key& key, const std::less<Key>&) {
+        std::size_t position = 0;
+        for (std::size_t i = 0; i < count; i++) position += static_cast<std::size_t>(keys[i] < key);
+        return position;
+    }
+};
+
+// Sorted map from Key to Value stored as a B+ tree. Every key/value pair lives
+// in a leaf; leaves are chained for in-order walks, and inner nodes hold only
+// separator keys. All leaves are at the same depth, so lookups, inserts and
+// erases are O(log n) whatever order keys arrive in.
+// Key and Value must be default-constructible (nodes hold fixed-size arrays).
+template <typename Key, typename Value, typename Compare = std::less<Key>, typename Layout = DefaultLayout<Key>,
+          typename Allocator = std::allocator<std::pair<const Key, Value>>>
+class OrderedIndex {
+public:
+    explicit OrderedIndex(const Compare& compare = Compare(), const Allocator& allocator = Allocator())
+        : less(compare), leafAllocator(allocator), innerAllocator(allocator) {}
+
+    OrderedIndex(const OrderedIndex&) = delete;
+    OrderedIndex& operator=(const OrderedIndex&) = delete;
+
+    OrderedIndex(OrderedIndex&& other) noexcept
+        : less(std::move(other.less)), leafAllocator(std::move(other.leafAllocator)),
+          innerAllocator(std::move(other.innerAllocator)), root(other.root), first(other.first), count(other.count) {
+        other.root = nullptr;
+        other.first = nullptr;
+        other.count = 0;
+    }
+
+    ~OrderedIndex() { clear(); }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Add key with value. Returns false, leaving the index unchanged, if key is already present.
+    bool insert(const Key& key, const Value& value) {
+        if (!root) {
+            Leaf* leaf = newLeaf();
+            leaf->keys[0] = key;
+            leaf->values[0] = value;
+            leaf->count = 1;
+            root = first = leaf;
+            count = 1;
+            return true;
+        }
+        bool inserted = false;
+        Split split;
+        if (insertInto(root, key, value, inserted, split)) {
+            Inner* newRoot = newInner();
+            newRoot->keys[0] = std::move(split.separator);
+            newRoot->children[0] = root;
+            newRoot->children[1] = split.right;
+            newRoot->count = 1;
+            root = newRoot;
+        }
+        if (inserted) count++;
+        return inserted;
+    }
+
+    // Value stored under key, or nullptr
+    Value* find(const Key& key) {
+        Leaf* leaf = leafFor(key);
+        if (!leaf) return nullptr;
+        std::size_t i = Search::lowerBound(leaf->keys, leaf->count, key, less);
+        return i < leaf->count && !less(key, leaf->keys[i]) ? &leaf->values[i] : nullptr;
+    }
+
+    const Value* find(const Key& key) const { return const_cast<OrderedIndex*>(this)->find(key); }
+
+    bool contains(const Key& key) const { return find(key) != nullptr; }
+
+    // Remove key. Returns false if it was not present.
+    bool erase(const Key& key) {
+        if (!root || !eraseFrom(root, key)) return false;
+        count--;
+        if (!root->leaf && root->count == 0) {
+            // The root's last two children merged: the tree gets one level shorter
+            Inner* oldRoot = static_cast<Inner*>(root);
+            root = oldRoot->children[0];
+            deleteInner(oldRoot);
+        } else if (root->leaf && root->count == 0) {
+            deleteLeaf(static_cast<Leaf*>(root));
+            root = first = nullptr;
+        }
+        return true;
+    }
+
+    void clear() {
+        if (root) destroy(root);
+        root = first = nullptr;
+        count = 0;
+    }
+
+    // visit(key, value) for every entry in key order
+    template <typename Visitor>
+    void forEach(Visitor visit) {
+        for (Leaf* leaf = first; leaf; leaf = leaf->next) {
+            for (std::size_t i = 0; i < leaf->count; i++) visit(static_cast<const Key&>(leaf->keys[i]), leaf->values[i]);
+        }
+    }
+
+    template <typename Visitor>
+    void forEach(Visitor visit) const {
+        for (const Leaf* leaf = first; leaf; leaf = leaf->next) {
+            for (std::size_t i = 0; i < leaf->count; i++) visit(leaf->keys[i], leaf->values[i]);
+        }
+    }
+
+private:
+    static constexpr std::size_t maxKeys = Layout::maxKeys;
+    static constexpr std::size_t minKeys = maxKeys / 2; // Fewest keys a node other than the root may hold
+
+    using Search = KeySearch<Key, Compare>;
+
+    struct Node {
+        bool leaf;
+        uint32_t count = 0;
+        Key keys[maxKeys];
+
+        explicit Node(bool isLeaf) : leaf(isLeaf) {}
+    };
+
+    struct Leaf : Node {
+        Value values[maxKeys];
+        Leaf* next = nullptr;
+
+        Leaf() : Node(true) {}
+    };
+
+    // children[i] holds keys below keys[i]; children[i + 1] holds keys from keys[i] up
+    struct Inner : Node {
+        Node* children[maxKeys + 1];
+
+        Inner() : Node(false) {}
+    };
+
+    struct Split {
+        Key separator;
+        Node* right = nullptr;
+    };
+
+    using LeafTraits = typename std::allocator_traits<Allocator>::template rebind_traits<Leaf>;
+    using InnerTraits = typename std::allocator_traits<Allocator>::template rebind_traits<Inner>;
+
+    Compare less;
+    typename LeafTraits::allocator_type leafAllocator;
+    typename InnerTraits::allocator_type innerAllocator;
+    Node* root = nullptr;
+    Leaf* first = nullptr; // Leftmost leaf, where in-order walks start
+    std::size_t count = 0;
+
+    Leaf* newLeaf() {
+        Leaf* leaf = LeafTraits::allocate(leafAllocator, 1);
+        LeafTraits::construct(leafAllocator, leaf);
+        return leaf;
+    }
+
+    Inner* newInner() {
+        Inner* inner = InnerTraits::allocate(innerAllocator, 1);
+        InnerTraits::construct(innerAllocator, inner);
+        return inner;
+    }
+
+    void deleteLeaf(Leaf* leaf) {
+        LeafTraits::destroy(leafAllocator, leaf);
+        LeafTraits::deallocate(leafAllocator, leaf, 1);
+    }
+
+    void deleteInner(Inner* inner) {
+        InnerTraits::destroy(innerAllocator, inner);
+        InnerTraits::deallocate(innerAllocator, inner, 1);
+    }
+
+    void destroy(Node* node) {
+        if (node->leaf) {
+            deleteLeaf(static_cast<Leaf*>(node));
+            return;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        for (std::size_t i = 0; i <= inner->count; i++) destroy(inner->children[i]);
+        deleteInner(inner);
+    }
+
+    // Which child of inner covers key
+    std::size_t childFor(const Inner* inner, const Key& key) const {
+        std::size_t i = Search::lowerBound(inner->keys, inner->count, key, less);
+        if (i < inner->count && !less(key, inner->keys[i])) i++; // Equal to a separator: it starts the right subtree
+        return i;
+    }
+
+    Leaf* leafFor(const Key& key) const {
+        Node* node = root;
+        if (!node) return nullptr;
+        while (!node->leaf) {
+            const Inner* inner = static_cast<const Inner*>(node);
+            node = inner->children[childFor(inner, key)];
+        }
+        return static_cast<Leaf*>(node);
+    }
+
+    // Insert below node. Returns true if node split, with the new right half in split.
+    bool insertInto(Node* node, const Key& key, const Value& value, bool& inserted, Split& split) {
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            std::size_t i = Search::lowerBound(leaf->keys, leaf->count, key, less);
+            if (i < leaf->count && !less(key, leaf->keys[i])) return false; // Already present
+            inserted = true;
+            if (leaf->count < maxKeys) {
+                insertAt(leaf, i, key, value);
+                return false;
+            }
+            // Full: move the upper half to a new leaf, then insert into whichever half the key belongs to
+            Leaf* right = newLeaf();
+            std::size_t mid = maxKeys / 2;
+            std::move(leaf->keys + mid, leaf->keys + maxKeys, right->keys);
+            std::move(leaf->values + mid, leaf->values + maxKeys, right->values);
+            right->count = static_cast<uint32_t>(maxKeys - mid);
+            leaf->count = static_cast<uint32_t>(mid);
+            right->next = leaf->next;
+            leaf->next = right;
+            if (i <= mid) {
+                insertAt(leaf, i, key, value);
+            } else {
+                insertAt(right, i - mid, key, value);
+            }
+            split.separator = right->keys[0];
+            split.right = right;
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        std::size_t c = childFor(inner, key);
+        Split below;
+        if (!insertInto(inner->children[c], key, value, inserted, below)) return false;
+        if (inner->count < maxKeys) {
+            insertChild(inner, c, std::move(below.separator), below.right);
+            return false;
+        }
+        // Full: keys[mid] moves up, keys and children after it go to a new node
+        Inner* right = newInner();
+        std::size_t mid = maxKeys / 2;
+        split.separator = std::move(inner->keys[mid]);
+        std::move(inner->keys + mid + 1, inner->keys + maxKeys, right->keys);
+        std::copy(inner->children + mid + 1, inner->children + maxKeys + 1, right->children);
+        right->count = static_cast<uint32_t>(maxKeys - mid - 1);
+        inner->count = static_cast<uint32_t>(mid);
+        if (c <= mid) {
+            insertChild(inner, c, std::move(below.separator), below.right);
+        } else {
+            insertChild(right, c - mid - 1, std::move(below.separator), below.right);
+        }
+        split.right = right;
+        return true;
+    }
+
+    static void insertAt(Leaf* leaf, std::size_t i, const Key& key, const Value& value) {
+        std::move_backward(leaf->keys + i, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        std::move_backward(leaf->values + i, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+        leaf->keys[i] = key;
+        leaf->values[i] = value;
+        leaf->count++;
+    }
+
+    // Add separator after children[c], with right as the child following it
+    static void insertChild(Inner* inner, std::size_t c, Key separator, Node* right) {
+        std::move_backward(inner->keys + c, inner->keys + inner->count, inner->keys + inner->count + 1);
+        std::copy_backward(inner->children + c + 1, inner->children + inner->count + 1,
+                           inner->children + inner->count + 2);
+        inner->keys[c] = std::move(separator);
+        inner->children[c + 1] = right;
+        inner->count++;
+    }
+
+    // Remove key below node, rebalancing any child left with too few keys
+    bool eraseFrom(Node* node, const Key& key) {
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            std::size_t i = Search::lowerBound(leaf->keys, leaf->count, key, less);
+            if (i == leaf->count || less(key, leaf->keys[i])) return false;
+            std::move(leaf->keys + i + 1, leaf->keys + leaf->count, leaf->keys + i);
+            std::move(leaf->values + i + 1, leaf->values + leaf->count, leaf->values + i);
+            leaf->count--;
+            return true;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        std::size_t c = childFor(inner, key);
+        if (!eraseFrom(inner->children[c], key)) return false;
+        if (inner->children[c]->count < minKeys) rebalance(inner, c);
+        return true;
+    }
+
+    // Top up children[c] from a sibling with keys to spare, or merge it with one
+    void rebalance(Inner* parent, std::size_t c) {
+        Node* left = c > 0 ? parent->children[c - 1] : nullptr;
+        Node* right = c < parent->count ? parent->children[c + 1] : nullptr;
+        if (left && left->count > minKeys) {
+            borrowFromLeft(parent, c);
+        } else if (right && right->count > minKeys) {
+            borrowFromRight(parent, c);
+        } else if (left) {
+            merge(parent, c - 1);
+        } else if (right) {
+            merge(parent, c);
+        }
+    }
+
+    void borrowFromLeft(Inner* parent, std::size_t c) {
+        Node* node = parent->children[c];
+        Node* sibling = parent->children[c - 1];
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            Leaf* from = static_cast<Leaf*>(sibling);
+            insertAt(leaf, 0, from->keys[from->count - 1], from->values[from->count - 1]);
+            from->count--;
+            parent->keys[c - 1] = leaf->keys[0];
+            return;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        Inner* from = static_cast<Inner*>(sibling);
+        std::move_backward(inner->keys, inner->keys + inner->count, inner->keys + inner->count + 1);
+        std::copy_backward(inner->children, inner->children + inner->count + 1, inner->children + inner->count + 2);
+        inner->keys[0] = std::move(parent->keys[c - 1]);
+        inner->children[0] = from->children[from->count];
+        inner->count++;
+        parent->keys[c - 1] = std::move(from->keys[from->count - 1]);
+        from->count--;
+    }
+
+    void borrowFromRight(Inner* parent, std::size_t c) {
+        Node* node = parent->children[c];
+        Node* sibling = parent->children[c + 1];
+        if (node->leaf) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            Leaf* from = static_cast<Leaf*>(sibling);
+            leaf->keys[leaf->count] = std::move(from->keys[0]);
+            leaf->values[leaf->count] = std::move(from->values[0]);
+            leaf->count++;
+            std::move(from->keys + 1, from->keys + from->count, from->keys);
+            std::move(from->values + 1, from->values + from->count, from->values);
+            from->count--;
+            parent->keys[c] = from->keys[0];
+            return;
+        }
+        Inner* inner = static_cast<Inner*>(node);
+        Inner* from = static_cast<Inner*>(sibling);
+        inner->keys[inner->count] = std::move(parent->keys[c]);
+        inner->children[inner->count + 1] = from->children[0];
+        inner->count++;
+        parent->keys[c] = std::move(from->keys[0]);
+        std::move(from->keys + 1, from->keys + from->count, from->keys);
+        std::copy(from->children + 1, from->children + from->count + 1, from->children);
+        from->count--;
+    }
+
+    // Fold children[s + 1] into children[s] and drop the separator between them
+    void merge(Inner* parent, std::size_t s) {
+        Node* leftNode = parent->children[s];
+        Node* rightNode = parent->children[s + 1];
+        if (leftNode->leaf) {
+            Leaf* left = static_cast<Leaf*>(leftNode);
+            Leaf* right = static_cast<Leaf*>(rightNode);
+            std::move(right->keys, right->keys + right->count, left->keys + left->count);
+            std::move(right->values, right->values + right->count, left->values + left->count);
+            left->count += right->count;
+            left->next = right->next;
+            deleteLeaf(right);
+        } else {
+            Inner* left = static_cast<Inner*>(leftNode);
+            Inner* right = static_cast<Inner*>(rightNode);
+            left->keys[left->count] = std::move(parent->keys[s]);
+            std::move(right->keys, right->keys + right->count, left->keys + left->count + 1);
+            std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+            left->count += right->count + 1;
+            deleteInner(right);
+        }
+        std::move(parent->keys + s + 1, parent->keys + parent->count, parent->keys + s);
+        std::copy(parent->children + s + 2, parent->children + parent->count + 1, parent->children + s + 1);
+        parent->count--;
+    }
+};
+
+#endif
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "orderedIndex.h"
+
+using namespace std;
+
+// Compares OrderedIndex with std::map on the same operations, for int keys
+// (parcel IDs) and string keys (event names).
+
+using BenchClock = chrono::steady_clock;
+
+// Thin adapters so one benchmark body drives both containers
+template <typename Key>
+struct IndexUnderTest {
+    OrderedIndex<Key, int> index;
+    static const char* name() { return "OrderedIndex"; }
+    bool insert(const Key& key, int value) { return index.insert(key, value); }
+    const int* find(const Key& key) const { return index.find(key); }
+    bool erase(const Key& key) { return index.erase(key); }
+    long long sum() const {
+        long long total = 0;
+        index.forEach([&](const Key&, int value) { total += value; });
+        return total;
+    }
+};
+
+template <typename Key>
+struct MapUnderTest {
+    map<Key, int> index;
+    static const char* name() { return "std::map"; }
+    bool insert(const Key& key, int value) { return index.insert({key, value}).second; }
+    const int* find(const Key& key) const {
+        auto it = index.find(key);
+        return it == index.end() ? nullptr : &it->second;
+    }
+    bool erase(const Key& key) { return index.erase(key) == 1; }
+    long long sum() const {
+        long long total = 0;
+        for (const auto& entry : index) total += entry.second;
+        return total;
+    }
+};
+
+template <typename Body>
+double nsPerOp(size_t ops, Body body) {
+    BenchClock::time_point start = BenchClock::now();
+    body();
+    return chrono::duration<double, nano>(BenchClock::now() - start).count() / max<size_t>(1, ops);
+}
+
+// Keys in random order, plus keys that are never inserted
+template <typename Key, typename MakeKey>
+void makeKeys(size_t n, MakeKey makeKey, mt19937& rng, vector<Key>& present, vector<Key>& absent) {
+    present.clear();
+    absent.clear();
+    for (size_t i = 0; i < n; i++) {
+        present.push_back(makeKey(2 * i));
+        absent.push_back(makeKey(2 * i + 1));
+    }
+    shuffle(present.begin(), present.end(), rng);
+    shuffle(absent.begin(), absent.end(), rng);
+}
+
+template <typename Container, typename Key>
+void run(const char* keyType, const vector<Key>& present, const vector<Key>& absent, mt19937& rng) {
+    size_t n = present.size();
+    Container container;
+    long long checksum = 0;
+    double insertNs = nsPerOp(n, [&] {
+        for (size_t i = 0; i < n; i++) container.insert(present[i], static_cast<int>(i));
+    });
+    vector<Key> lookups = present;
+    shuffle(lookups.begin(), lookups.end(), rng);
+    double hitNs = nsPerOp(n, [&] {
+        for (const Key& key : lookups) checksum += *container.find(key);
+    });
+    double missNs = nsPerOp(n, [&] {
+        for (const Key& key : absent) checksum += container.find(key) != nullptr;
+    });
+    double scanNs = nsPerOp(n, [&] { checksum += container.sum(); });
+    double eraseNs = nsPerOp(n, [&] {
+        for (const Key& key : lookups) checksum += container.erase(key);
+    });
+    printf("  %-7s %-13s %10zu %10.1f %10.1f %10.1f %10.2f %10.1f   (checksum %lld)\n", keyType, Container::name(), n,
+           insertNs, hitNs, missNs, scanNs, eraseNs, checksum);
+}
+
+int main(int argc, char** argv) {
+    size_t maxKeys = 1000000;
+    if (argc > 1) maxKeys = stoull(argv[1]);
+    mt19937 rng(1);
+
+    printf("Nanoseconds per operation (keys inserted, looked up and erased in random order)\n");
+    printf("  %-7s %-13s %10s %10s %10s %10s %10s %10s\n", "key", "container", "keys", "insert", "find hit",
+           "find miss", "scan", "erase");
+    for (size_t n = 1000; n <= maxKeys; n *= 10) {
+        vector<int> intKeys, missingInts;
+        makeKeys<int>(n, [](size_t i) { return static_cast<int>(i); }, rng, intKeys, missingInts);
+        run<IndexUnderTest<int>>("int", intKeys, missingInts, rng);
+        run<MapUnderTest<int>>("int", intKeys, missingInts, rng);
+
+        // Event-style names: a shared prefix makes comparisons look past the first bytes
+        vector<string> stringKeys, missingStrings;
+        makeKeys<string>(n, [](size_t i) { return "Event " + to_string(i); }, rng, stringKeys, missingStrings);
+        run<IndexUnderTest<string>>("string", stringKeys, missingStrings, rng);
+        run<MapUnderTest<string>>("string", stringKeys, missingStrings, rng);
+    }
+    return 0;
+}